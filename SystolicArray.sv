@@ -21,9 +21,17 @@
 `include "globals.svh"
 `include "msFlipFlop.svh"
 
+// Geometry, set by M_MMA and K_MMA of the Makefile
+`ifndef SA_M_MMA
+	`define SA_M_MMA 1
+`endif
+`ifndef SA_K_MMA
+	`define SA_K_MMA 8
+`endif
+
 module SystolicArray #(
-		parameter M_MMA = 1,
-		parameter K_MMA = 8
+		parameter M_MMA = `SA_M_MMA,
+		parameter K_MMA = `SA_K_MMA // even: two phase-shifted FMA chains per row
 		)
 		(
 		input logic 						 clk,
@@ -39,7 +47,7 @@ module SystolicArray #(
 	generate
 		for (genvar m_mma = 0; m_mma < M_MMA; m_mma++) begin : fma_m
 
-			accNormalSigned_t fmaAccOut[K_MMA-3:0];
+			accNormalSigned_t fmaAccOut[K_MMA-3:0] /*verilator public*/; // read by the cone of influence simulation
 	 
 			for (genvar k_mma = 0; k_mma < K_MMA; k_mma++) begin : fma_k
 				// The first fmas read Acc directly from input port
@@ -1,9 +1,15 @@
 #! /bin/bash
 
-ar -M <<EOM
-    OPEN systolicArraySim.a
-    ADDLIB netlist/obj_dir/VSystolicArray_netlist__ALL.a
-    SAVE
-    END
-EOM
-ranlib systolicArraySim.a
+# Adds the verilated models to the library. $1: library, $2...: model archives
+LIB=$1
+shift
+
+{
+    echo "OPEN $LIB"
+    for ARCHIVE in "$@"; do
+        echo "ADDLIB $ARCHIVE"
+    done
+    echo "SAVE"
+    echo "END"
+} | ar -M
+ranlib $LIB
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <vector>
+
+#include "helpers.h"
+
+#include "systolicArraySim.h"
+
+static void usage(const char * appName)
+{
+	sasInfo("Usage: %s [-j jobs] [-r runs] [-f FI region]\n", appName);
+	sasInfo("\tSimulation speed and memory of the linked geometry: Each run simulates a queue of jobs MMAs,\n");
+	sasInfo("\tfault free on the RTL model and on the netlist, and on the netlist with a transient fault.\n");
+	sasInfo("\tThe netlist is that of the FI region (default: SystolicArray, the fully instrumented one).\n");
+}
+
+// Resident set size in bytes
+static size_t rssGet()
+{
+	size_t pages = 0;
+	FILE * file = fopen("/proc/self/statm", "r");
+	if(nullptr != file)
+	{
+		if(1 != fscanf(file, "%*u %lu", &pages))
+		{
+			pages = 0;
+		}
+		fclose(file);
+	}
+
+	return pages * sysconf(_SC_PAGESIZE);
+}
+
+// Simulation speed in cycles per second: saSim simulates the jobs of matA / matB / matC runs times
+static int cyclesPerSecond(SystolicArraySim * saSim, const std::vector<double> &matA, const std::vector<double> &matB,
+		const std::vector<double> &matC, size_t jobCnt, size_t runs, SystolicArraySim::fiMode mode, double * speed)
+{
+	std::vector<double> out(matC.size());
+	const SystolicArraySim::job_t job = {matA.data(), saSim->Kmma(), matB.data(), saSim->Nmma(), out.data(), saSim->Nmma()};
+
+	double seconds = 0;
+	for(size_t run = 0; run < runs; run++)
+	{
+		out = matC;
+
+		if(saSim->DispatchMma(job, jobCnt, 1))
+		{
+			sasError("DispatchMma failed\n");
+			return -1;
+		}
+
+		if((SystolicArraySim::fiMode::None != mode) && (SystolicArraySim::fiMode::None == saSim->FiSetRTL(mode).Mode))
+		{
+			sasError("FiSetRTL failed\n");
+			return -1;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		if(saSim->ExecRtl())
+		{
+			sasError("ExecRtl failed\n");
+			return -1;
+		}
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if((SystolicArraySim::fiMode::None != mode) && saSim->FiResetRTL())
+		{
+			sasError("FiResetRTL failed\n");
+			return -1;
+		}
+	}
+
+	*speed = (runs * saSim->CyclesRequired(jobCnt)) / seconds;
+	return 0;
+}
+
+int main(int argc, char ** argv)
+{
+	size_t jobCnt = 64;
+	size_t runs = 10;
+	const char * fiRegion = nullptr;
+
+	int opt;
+	while(-1 != (opt = getopt(argc, argv, "j:r:f:h")))
+	{
+		switch(opt)
+		{
+		case 'j':
+			jobCnt = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'r':
+			runs = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'f':
+			fiRegion = optarg;
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if((0 == jobCnt) || (0 == runs))
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	srand(time(NULL));
+
+	const size_t rssStart = rssGet();
+	SystolicArraySim saSim;
+	if((nullptr != fiRegion) && saSim.FiRegionSet(fiRegion))
+	{
+		sasFatal("FiRegionSet failed\n");
+	}
+
+	std::vector<double> matA(jobCnt * saSim.Mmma() * saSim.Kmma());
+	std::vector<double> matB(saSim.Kmma() * saSim.Nmma());
+	std::vector<double> matC(jobCnt * saSim.Mmma() * saSim.Nmma());
+	for(std::vector<double> * mat : {&matA, &matB, &matC})
+	{
+		for(double &elem : *mat)
+		{
+			elem = randomDouble(-5, 5, 0.1);
+		}
+	}
+
+	// Models are instantiated by the first run of each: Fault free runs take the RTL model,
+	// those with the fast model disabled or a fault the netlist
+	double rtlSpeed;
+	if(cyclesPerSecond(&saSim, matA, matB, matC, jobCnt, runs, SystolicArraySim::fiMode::None, &rtlSpeed))
+	{
+		sasFatal("RTL model run failed\n");
+	}
+	const size_t rssRtl = rssGet();
+
+	saSim.FastModelEn(false);
+	double netlistSpeed;
+	if(cyclesPerSecond(&saSim, matA, matB, matC, jobCnt, runs, SystolicArraySim::fiMode::None, &netlistSpeed))
+	{
+		sasFatal("Netlist run failed\n");
+	}
+	const size_t rssNetlist = rssGet();
+
+	double transientSpeed;
+	if(cyclesPerSecond(&saSim, matA, matB, matC, jobCnt, runs, SystolicArraySim::fiMode::Transient, &transientSpeed))
+	{
+		sasFatal("Transient fault run failed\n");
+	}
+
+	struct rusage resources;
+	getrusage(RUSAGE_SELF, &resources);
+
+	sasInfo("Geometry = %lu x %lu FMAs (M_MMA x K_MMA), FI region = %s\n", SystolicArraySim::MmmaRtl(), saSim.Kmma(),
+			saSim.FiRegion());
+	sasInfo("Cycles per run = %lu (%lu jobs), runs = %lu\n", saSim.CyclesRequired(jobCnt), jobCnt, runs);
+	sasInfo("RTL model: %.0f cycles/s, %lu kB\n", rtlSpeed, (rssRtl - rssStart) / 1024);
+	sasInfo("Netlist: %.0f cycles/s, %lu kB\n", netlistSpeed, (rssNetlist - rssRtl) / 1024);
+	sasInfo("Netlist, transient fault: %.0f cycles/s\n", transientSpeed);
+	sasInfo("Max. RSS = %li kB\n", resources.ru_maxrss);
+
+	return 0;
+}
@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "helpers.h"
+
+#include "faultDictionary.h"
+
+FaultDictionary::FaultDictionary()
+{
+}
+
+FaultDictionary::~FaultDictionary()
+{
+}
+
+int FaultDictionary::Load(const char * path)
+{
+	if(!Sites_.empty())
+	{
+		sasError("Dictionary not empty\n");
+		return -1;
+	}
+
+	FILE * file = fopen(path, "r");
+	if(nullptr == file)
+	{
+		sasError("Can't open %s\n", path);
+		return -2;
+	}
+
+	int ret = 0;
+	char * line = nullptr;
+	size_t lineSize = 0;
+	ssize_t lineLen;
+	while(0 < (lineLen = getline(&line, &lineSize, file)))
+	{
+		if(Apply(std::string(line, ('\n' == line[lineLen - 1]) ? lineLen - 1 : lineLen)))
+		{
+			sasError("Invalid entry %s", line);
+			ret = -3;
+			break;
+		}
+	}
+
+	free(line);
+	fclose(file);
+
+	return ret;
+}
+
+int FaultDictionary::Save(const char * path) const
+{
+	FILE * file = fopen(path, "w");
+	if(nullptr == file)
+	{
+		sasError("Can't open %s\n", path);
+		return -1;
+	}
+
+	for(const auto &site : Sites_)
+	{
+		fprintf(file, "S %u %u %lu ", site.AssignUUID, site.Width, site.Draws);
+		for(size_t inst = 0; inst < site.Chain.size(); inst++)
+		{
+			fprintf(file, (0 == inst) ? "%u" : "-%u", site.Chain[inst]);
+		}
+		fprintf(file, site.Chain.empty() ? "-\n" : "\n");
+	}
+
+	for(const auto &key : Patterns_)
+	{
+		for(const auto &pattern : key.second)
+		{
+			fprintf(file, "P %lu %u %u %lu", std::get<0>(key.first), std::get<1>(key.first), std::get<2>(key.first), pattern.second);
+			for(const uint32_t word : pattern.first)
+			{
+				fprintf(file, " %x", word);
+			}
+			fprintf(file, "\n");
+		}
+	}
+
+	if(fclose(file))
+	{
+		sasError("fclose failed\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+int FaultDictionary::Apply(const std::string &line)
+{
+	char type;
+	unsigned int assignUUID;
+	unsigned int width;
+	size_t draws;
+	char chain[256];
+
+	if((5 == sscanf(line.c_str(), "%c %u %u %lu %255s", &type, &assignUUID, &width, &draws, chain)) && ('S' == type))
+	{
+		site_t site = {{}, assignUUID, (uint16_t) width, draws, {}};
+		for(const char * pos = chain; ('\0' != *pos) && (0 != strcmp(chain, "-")); )
+		{
+			char * end;
+			site.Chain.push_back(strtoul(pos, &end, 10));
+			if((end == pos) || (('-' != *end) && ('\0' != *end)))
+			{
+				return -1;
+			}
+
+			pos = ('-' == *end) ? end + 1 : end;
+		}
+
+		Sites_.push_back(site);
+		Draws_ += draws;
+		return 0;
+	}
+
+	size_t siteIndex;
+	unsigned int bit;
+	unsigned int phase;
+	size_t count;
+	int offset;
+	if((5 == sscanf(line.c_str(), "%c %lu %u %u %lu%n", &type, &siteIndex, &bit, &phase, &count, &offset)) && ('P' == type) &&
+			(siteIndex < Sites_.size()) && (bit < Sites_[siteIndex].Width) && (2 > phase))
+	{
+		pattern_t pattern;
+		for(auto &word : pattern)
+		{
+			int wordLen;
+			if(1 != sscanf(line.c_str() + offset, " %x%n", &word, &wordLen))
+			{
+				return -1;
+			}
+
+			offset += wordLen;
+		}
+
+		Record(siteIndex, bit, phase, pattern, count);
+		return 0;
+	}
+
+	return -1;
+}
+
+size_t FaultDictionary::SiteAdd(const std::vector<uint16_t> &chain, uint32_t assignUUID, uint16_t width)
+{
+	Draws_++;
+
+	for(size_t site = 0; site < Sites_.size(); site++)
+	{
+		if((Sites_[site].AssignUUID == assignUUID) && (Sites_[site].Chain == chain))
+		{
+			Sites_[site].Draws++;
+			return site;
+		}
+	}
+
+	Sites_.push_back({chain, assignUUID, width, 1, {}});
+	return Sites_.size() - 1;
+}
+
+void FaultDictionary::Record(size_t site, uint16_t bit, uint8_t phase, const pattern_t &pattern, size_t count)
+{
+	Patterns_[std::make_tuple(site, bit, phase)][pattern] += count;
+
+	std::vector<uint16_t> &bits = Sites_[site].Bits;
+	const auto pos = std::lower_bound(bits.begin(), bits.end(), bit);
+	if((bits.end() == pos) || (*pos != bit))
+	{
+		bits.insert(pos, bit);
+	}
+}
+
+bool FaultDictionary::Characterized(size_t site, uint16_t bit) const
+{
+	return (site < Sites_.size()) && std::binary_search(Sites_[site].Bits.begin(), Sites_[site].Bits.end(), bit);
+}
+
+int FaultDictionary::SiteDraw(Prng * prng, size_t * site, uint16_t * bit) const
+{
+	size_t draws = 0;
+	for(const auto &candidate : Sites_)
+	{
+		draws += candidate.Bits.empty() ? 0 : candidate.Draws;
+	}
+
+	if(0 == draws)
+	{
+		sasError("No characterized sites\n");
+		return -1;
+	}
+
+	size_t draw = prng->Below(draws);
+	for(size_t candidate = 0; candidate < Sites_.size(); candidate++)
+	{
+		if(Sites_[candidate].Bits.empty())
+		{
+			continue;
+		}
+
+		if(draw < Sites_[candidate].Draws)
+		{
+			*site = candidate;
+			*bit = Sites_[candidate].Bits[prng->Below(Sites_[candidate].Bits.size())];
+			return 0;
+		}
+
+		draw -= Sites_[candidate].Draws;
+	}
+
+	return -1;
+}
+
+const FaultDictionary::pattern_t * FaultDictionary::PatternDraw(Prng * prng, size_t site, uint16_t bit, uint8_t phase, size_t * index) const
+{
+	const auto patterns = Patterns_.find(std::make_tuple(site, bit, phase));
+	if(Patterns_.end() == patterns)
+	{
+		return nullptr;
+	}
+
+	size_t count = 0;
+	for(const auto &pattern : patterns->second)
+	{
+		count += pattern.second;
+	}
+
+	size_t draw = prng->Below(count);
+	size_t patternIndex = 0;
+	for(const auto &pattern : patterns->second)
+	{
+		if(draw < pattern.second)
+		{
+			if(nullptr != index)
+			{
+				*index = patternIndex;
+			}
+
+			return &pattern.first;
+		}
+
+		draw -= pattern.second;
+		patternIndex++;
+	}
+
+	return nullptr;
+}
+
+const FaultDictionary::pattern_t * FaultDictionary::Pattern(size_t site, uint16_t bit, uint8_t phase, size_t index) const
+{
+	const auto patterns = Patterns_.find(std::make_tuple(site, bit, phase));
+	if((Patterns_.end() == patterns) || (patterns->second.size() <= index))
+	{
+		return nullptr;
+	}
+
+	return &std::next(patterns->second.begin(), index)->first;
+}
+
+size_t FaultDictionary::Unmasked(size_t site) const
+{
+	const pattern_t masked = {};
+
+	size_t count = 0;
+	for(auto patterns = Patterns_.lower_bound(key_t(site, 0, 0));
+			(Patterns_.end() != patterns) && (std::get<0>(patterns->first) == site); patterns++)
+	{
+		for(const auto &pattern : patterns->second)
+		{
+			count += (masked != pattern.first) ? pattern.second : 0;
+		}
+	}
+
+	return count;
+}
+
+// Save and load reproduce the dictionary, draws follow the recorded counts
+int FaultDictionary::UnitTest()
+{
+	FaultDictionary dict;
+	pattern_t masked = {};
+	pattern_t flipped = {};
+	flipped[Words + 1] = 0x10;
+
+	const size_t siteA = dict.SiteAdd({3, 1}, 17, 8);
+	const size_t siteB = dict.SiteAdd({}, 5, 1);
+	dict.SiteAdd({3, 1}, 17, 8);
+	dict.SiteAdd({3, 1}, 17, 8);
+
+	dict.Record(siteA, 2, 0, masked, 3);
+	dict.Record(siteA, 2, 0, flipped);
+	dict.Record(siteA, 7, 1, flipped);
+	dict.Record(siteB, 0, 1, masked);
+
+	if((2 != dict.Sites()) || (3 != dict.Site(siteA).Draws) || !dict.Characterized(siteA, 7) || dict.Characterized(siteA, 3))
+	{
+		sasError("Unexpected sites\n");
+		return -1;
+	}
+
+	char path[] = "/tmp/faultDictionaryTestXXXXXX";
+	const int tmpFd = mkstemp(path);
+	if(0 > tmpFd)
+	{
+		sasError("mkstemp failed\n");
+		return -1;
+	}
+	close(tmpFd);
+
+	FaultDictionary loaded;
+	if(dict.Save(path) || loaded.Load(path))
+	{
+		sasError("Save or load failed\n");
+		unlink(path);
+		return -1;
+	}
+	unlink(path);
+
+	if((loaded.Sites() != dict.Sites()) || (loaded.Site(siteA).Chain != dict.Site(siteA).Chain) ||
+			(loaded.Site(siteB).AssignUUID != dict.Site(siteB).AssignUUID) || !loaded.Site(siteB).Chain.empty() ||
+			(loaded.Site(siteA).Bits != dict.Site(siteA).Bits) || (loaded.Patterns_ != dict.Patterns_))
+	{
+		sasError("Loaded dictionary differs\n");
+		return -1;
+	}
+
+	if(nullptr != loaded.PatternDraw(&threadPrng(), siteA, 2, 1))
+	{
+		sasError("Pattern drawn for uncharacterized phase\n");
+		return -1;
+	}
+
+	if((2 != loaded.Unmasked(siteA)) || (0 != loaded.Unmasked(siteB)))
+	{
+		sasError("Site A has %lu, site B %lu unmasked patterns\n", loaded.Unmasked(siteA), loaded.Unmasked(siteB));
+		return -1;
+	}
+
+	const size_t drawCnt = 10000;
+	size_t flippedCnt = 0;
+	size_t siteACnt = 0;
+	for(size_t draw = 0; draw < drawCnt; draw++)
+	{
+		size_t index;
+		const pattern_t * pattern = loaded.PatternDraw(&threadPrng(), siteA, 2, 0, &index);
+		if(pattern != loaded.Pattern(siteA, 2, 0, index))
+		{
+			sasError("Pattern of the drawn index differs\n");
+			return -1;
+		}
+		flippedCnt += (flipped == *pattern);
+
+		size_t site;
+		uint16_t bit;
+		if(loaded.SiteDraw(&threadPrng(), &site, &bit) || !loaded.Characterized(site, bit))
+		{
+			sasError("SiteDraw failed\n");
+			return -1;
+		}
+		siteACnt += (siteA == site);
+	}
+
+	// Expected 1 / 4 and 3 / 4, 0.05 is far beyond the standard deviation of ~0.004
+	if((fabs(flippedCnt / (double) drawCnt - 0.25) > 0.05) || (fabs(siteACnt / (double) drawCnt - 0.75) > 0.05))
+	{
+		sasError("Drew flipped %lu, site A %lu times out of %lu\n", flippedCnt, siteACnt, drawCnt);
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef FAULTDICTIONARY_H_
+#define FAULTDICTIONARY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <array>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "prng.h"
+
+// Output error patterns of transient faults in the FMA netlist, characterized with random operands
+// (see SystolicArraySim::DictCharacterize) and drawn by the C model to inject RTL derived FMA faults.
+// A site is an assign of the FMA: ModuleInstanceChain below the FMA, and AssignUUID. The operations of
+// an FMA enter every second cycle, so a fault hits the Stages operations in flight. Its pattern holds
+// one XOR mask per stage, for the 65'b output of the operation which entered 2 * stage + phase cycles
+// before the fault. Patterns are kept per (site, bit, phase) with how often each occurred.
+//
+// File format: "S <assignUUID> <width> <draws> <chain>" per site (chain as "a-b-c", "-" if empty)
+// and "P <site> <bit> <phase> <count> <mask words>" per pattern, masks as hex words. Not thread-safe.
+
+class FaultDictionary {
+public:
+	FaultDictionary();
+	virtual ~FaultDictionary();
+
+	FaultDictionary & operator=(const FaultDictionary&) = delete;
+	FaultDictionary(const FaultDictionary &dict) = delete;
+
+	static const size_t Stages = 6; // FMA operations in flight
+	static const size_t Words = 3; // per 65'b value, as VlWide<3>
+
+	typedef std::array<uint32_t, Stages * Words> pattern_t; // all 0 if masked
+
+	typedef struct {
+		std::vector<uint16_t> Chain; // ModuleInstanceChain below the FMA
+		uint32_t AssignUUID;
+		uint16_t Width;
+		size_t Draws; // drawn uniformly over assigns while characterizing
+		std::vector<uint16_t> Bits; // characterized, ascending
+	} site_t;
+
+	int Load(const char * path); // into an empty dictionary
+	int Save(const char * path) const;
+
+	// Counts a draw of the site, returns its index
+	size_t SiteAdd(const std::vector<uint16_t> &chain, uint32_t assignUUID, uint16_t width);
+	void Record(size_t site, uint16_t bit, uint8_t phase, const pattern_t &pattern, size_t count = 1);
+
+	size_t Sites() const {return Sites_.size();};
+	const site_t &Site(size_t site) const {return Sites_[site];};
+	bool Characterized(size_t site, uint16_t bit) const;
+
+	// Site drawn like RandomFiGet, i.e. by draws, and one of its characterized bits uniformly
+	int SiteDraw(Prng * prng, size_t * site, uint16_t * bit) const;
+
+	// Pattern drawn by occurrence, nullptr if not characterized. index: Its index, see Pattern
+	const pattern_t * PatternDraw(Prng * prng, size_t site, uint16_t bit, uint8_t phase, size_t * index = nullptr) const;
+
+	// Pattern index of (site, bit, phase), e.g. to replay a drawn one. nullptr if there is none
+	const pattern_t * Pattern(size_t site, uint16_t bit, uint8_t phase, size_t index) const;
+
+	// Occurrences of the site's patterns which corrupt an output (not all 0)
+	size_t Unmasked(size_t site) const;
+
+	static int UnitTest();
+
+private:
+	typedef std::tuple<size_t, uint16_t, uint8_t> key_t; // site, bit, phase
+
+	std::vector<site_t> Sites_;
+	size_t Draws_ = 0;
+	std::map<key_t, std::map<pattern_t, size_t>> Patterns_;
+
+	int Apply(const std::string &line);
+};
+
+#endif /* FAULTDICTIONARY_H_ */
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "helpers.h"
+
+#include "systolicArraySim.h"
+#include "faultDictionary.h"
+
+static void usage(const char * appName)
+{
+	sasInfo("Usage: %s -f dictionary -i FMA instances [-s sites] [-o operand sets] [-e exponent range]\n", appName);
+	sasInfo("\tCharacterizes transient faults of sites drawn from the FMAs of the netlist and adds them to the dictionary.\n");
+	sasInfo("\tFMA instances: Comma separated first module instance chain entries, see SystolicArraySim::CoiEnable\n");
+}
+
+int main(int argc, char ** argv)
+{
+	const char * path = nullptr;
+	std::vector<uint16_t> fmaInstances;
+	size_t siteCnt = 16;
+	size_t operandSets = 16;
+	int expRange = 5;
+
+	int opt;
+	while(-1 != (opt = getopt(argc, argv, "f:i:s:o:e:h")))
+	{
+		switch(opt)
+		{
+		case 'f':
+			path = optarg;
+			break;
+
+		case 'i':
+			for(const char * pos = optarg; '\0' != *pos; pos += (',' == *pos) ? 1 : 0)
+			{
+				char * end;
+				fmaInstances.push_back(strtoul(pos, &end, 0));
+				if((end == pos) || ((',' != *end) && ('\0' != *end)))
+				{
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+
+				pos = end;
+			}
+			break;
+
+		case 's':
+			siteCnt = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'o':
+			operandSets = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'e':
+			expRange = strtol(optarg, NULL, 0);
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if((nullptr == path) || fmaInstances.empty())
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	srand(time(NULL));
+
+	// Adds to an existing dictionary, so it can be refined over several runs
+	FaultDictionary dict;
+	if((0 == access(path, F_OK)) && dict.Load(path))
+	{
+		sasFatal("Load failed\n");
+	}
+
+	if(SystolicArraySim::DictCharacterize(&dict, fmaInstances, siteCnt, operandSets, expRange))
+	{
+		sasFatal("DictCharacterize failed\n");
+	}
+
+	if(dict.Save(path))
+	{
+		sasFatal("Save failed\n");
+	}
+
+	sasInfo("Sites = %lu\n", dict.Sites());
+
+	return 0;
+}
@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "helpers.h"
+
+#include "faultSampler.h"
+
+static const char * const outcomeNames[FaultSampler::OutcomeCnt] = {"MASKED", "SDC", "DETECTED"};
+
+// z with P(-z < X < z) = confidence for standard normal X
+static double zGet(double confidence)
+{
+	double low = 0;
+	double high = 10;
+	for(size_t iter = 0; iter < 64; iter++)
+	{
+		const double mid = (low + high) / 2;
+		if(erf(mid / sqrt(2.)) < confidence)
+		{
+			low = mid;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return (low + high) / 2;
+}
+
+FaultSampler::FaultSampler(size_t chainDepth) : ChainDepth_(chainDepth)
+{
+}
+
+FaultSampler::~FaultSampler()
+{
+	if(0 <= Fd_)
+	{
+		close(Fd_);
+	}
+}
+
+const char * FaultSampler::OutcomeName(outcome result)
+{
+	return outcomeNames[(size_t) result];
+}
+
+int FaultSampler::OutcomeGet(const char * name, outcome * result)
+{
+	for(size_t index = 0; index < OutcomeCnt; index++)
+	{
+		if(0 == strcmp(name, outcomeNames[index]))
+		{
+			*result = (outcome) index;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+std::string FaultSampler::Stratum(const std::vector<uint16_t> &chain, size_t width) const
+{
+	std::string stratum;
+	for(size_t inst = 0; (inst < chain.size()) && (inst < ChainDepth_); inst++)
+	{
+		stratum += (0 == inst ? "" : "-") + std::to_string(chain[inst]);
+	}
+
+	// Width classes: 1, 2, 3-4, 5-8, ...
+	size_t widthClass = 1;
+	while(widthClass < width)
+	{
+		widthClass *= 2;
+	}
+
+	return stratum + "/w" + std::to_string(widthClass);
+}
+
+int FaultSampler::Open(const char * path)
+{
+	if(0 <= Fd_)
+	{
+		sasError("Log already open\n");
+		return -1;
+	}
+
+	Fd_ = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+	if(0 > Fd_)
+	{
+		sasError("Can't open %s\n", path);
+		return -2;
+	}
+
+	if(const int syncRet = Sync())
+	{
+		close(Fd_);
+		Fd_ = -1;
+		return syncRet;
+	}
+
+	return 0;
+}
+
+int FaultSampler::Sync()
+{
+	if(0 > Fd_)
+	{
+		return 0;
+	}
+
+	// One write, so entries of concurrent experiments don't interleave
+	std::string entries;
+	for(const auto &candidate : PendingCandidates_)
+	{
+		entries += "C " + candidate.first.first + " " + std::to_string(candidate.first.second) + " " +
+				std::to_string(candidate.second) + "\n";
+	}
+	entries += PendingRecords_;
+
+	PendingCandidates_.clear();
+	PendingRecords_.clear();
+
+	if(!entries.empty() && (write(Fd_, entries.data(), entries.size()) != (ssize_t) entries.size()))
+	{
+		sasError("write failed\n");
+		return -1;
+	}
+
+	char buffer[4096];
+	ssize_t readCnt;
+	while(0 < (readCnt = pread(Fd_, buffer, sizeof(buffer), ReadOffset_)))
+	{
+		ReadOffset_ += readCnt;
+		Partial_.append(buffer, readCnt);
+
+		size_t start = 0;
+		for(size_t end = Partial_.find('\n'); std::string::npos != end; end = Partial_.find('\n', start))
+		{
+			if(Apply(Partial_.substr(start, end - start)))
+			{
+				sasWarning("Skipping invalid log entry\n");
+			}
+
+			start = end + 1;
+		}
+
+		Partial_.erase(0, start);
+	}
+
+	if(0 > readCnt)
+	{
+		sasError("pread failed\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+int FaultSampler::Apply(const std::string &line)
+{
+	char type;
+	char stratum[256];
+	char name[16];
+	size_t width;
+	size_t count;
+
+	if((4 == sscanf(line.c_str(), "%c %255s %lu %lu", &type, stratum, &width, &count)) && ('C' == type))
+	{
+		Strata_[stratum].Bits += width * count;
+		Bits_ += width * count;
+		return 0;
+	}
+
+	outcome result;
+	if((3 == sscanf(line.c_str(), "%c %255s %15s", &type, stratum, name)) && ('R' == type) && !OutcomeGet(name, &result))
+	{
+		stratum_t &stratumRef = Strata_[stratum];
+		stratumRef.Experiments++;
+		stratumRef.Counts[(size_t) result]++;
+		Experiments_++;
+		return 0;
+	}
+
+	return -1;
+}
+
+void FaultSampler::Candidate(const std::string &stratum, size_t width)
+{
+	if(0 <= Fd_)
+	{
+		PendingCandidates_[std::make_pair(stratum, width)]++;
+		return;
+	}
+
+	Strata_[stratum].Bits += width;
+	Bits_ += width;
+}
+
+void FaultSampler::Record(const std::string &stratum, outcome result)
+{
+	if(0 <= Fd_)
+	{
+		PendingRecords_ += "R " + stratum + " " + OutcomeName(result) + "\n";
+		return;
+	}
+
+	stratum_t &stratumRef = Strata_[stratum];
+	stratumRef.Experiments++;
+	stratumRef.Counts[(size_t) result]++;
+	Experiments_++;
+}
+
+std::string FaultSampler::Target() const
+{
+	// Greedy Neyman allocation: One more experiment in stratum h reduces the variance of the
+	// estimate by W_h^2 * s_h^2 / (n_h * (n_h + 1)). Strata without experiments go first, largest first
+	std::string target;
+	double targetGain = -1;
+	bool targetUnsampled = false;
+
+	for(const auto &stratum : Strata_)
+	{
+		const double weight = Bits_ ? stratum.second.Bits / Bits_ : 0;
+		const size_t n = stratum.second.Experiments;
+
+		if(0 == n)
+		{
+			if(!targetUnsampled || (weight > targetGain))
+			{
+				target = stratum.first;
+				targetGain = weight;
+				targetUnsampled = true;
+			}
+
+			continue;
+		}
+
+		if(targetUnsampled)
+		{
+			continue;
+		}
+
+		// Largest variance of all outcomes, smoothed so few experiments without an outcome don't count as certain
+		double variance = 0;
+		for(size_t result = 0; result < OutcomeCnt; result++)
+		{
+			const double p = (stratum.second.Counts[result] + 0.5) / (n + 1);
+			variance = std::max(variance, p * (1 - p));
+		}
+
+		const double gain = weight * weight * variance / (n * (n + 1.));
+		if(gain > targetGain)
+		{
+			target = stratum.first;
+			targetGain = gain;
+		}
+	}
+
+	return target;
+}
+
+FaultSampler::estimate_t FaultSampler::Estimate(outcome result, double confidence) const
+{
+	// Stratified estimate. The rate of strata without experiments may be anything in [0, 1],
+	// so their weight is added to the half width
+	double rate = 0;
+	double variance = 0;
+	double weightUnsampled = 0;
+
+	for(const auto &stratum : Strata_)
+	{
+		const double weight = Bits_ ? stratum.second.Bits / Bits_ : 0;
+		const size_t n = stratum.second.Experiments;
+
+		if(0 == n)
+		{
+			weightUnsampled += weight;
+			continue;
+		}
+
+		const size_t count = stratum.second.Counts[(size_t) result];
+		const double p = (count + 0.5) / (n + 1);
+
+		rate += weight * count / n;
+		variance += weight * weight * p * (1 - p) / n;
+	}
+
+	if(0 == Bits_)
+	{
+		return {0.5, 0.5};
+	}
+
+	estimate_t estimate;
+	estimate.Rate = rate + weightUnsampled / 2;
+	estimate.HalfWidth = zGet(confidence) * sqrt(variance) + weightUnsampled / 2;
+
+	return estimate;
+}
+
+bool FaultSampler::Done(double halfWidth, double confidence, size_t minExperiments) const
+{
+	if(Experiments_ < minExperiments)
+	{
+		return false;
+	}
+
+	for(size_t result = 0; result < OutcomeCnt; result++)
+	{
+		if(Estimate((outcome) result, confidence).HalfWidth > halfWidth)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Synthetic campaign with known per bit rates: Narrow (1 bit) signals are the majority of assigns,
+// but wide ones the majority of bits
+int FaultSampler::UnitTest()
+{
+	typedef struct {
+		std::vector<uint16_t> Chain;
+		size_t Width;
+		size_t Assigns;
+		double Sdc;
+		double Detected;
+	} population_t;
+
+	const std::vector<population_t> population = {
+			{{0, 1}, 1, 1000, 0.1, 0.0},
+			{{0, 2}, 64, 100, 0.5, 0.2},
+			{{1, 1}, 16, 50, 0.2, 0.6}};
+
+	double bits = 0;
+	double sdcBits = 0;
+	double detectedBits = 0;
+	size_t assigns = 0;
+	for(const auto &group : population)
+	{
+		bits += group.Width * group.Assigns;
+		sdcBits += group.Sdc * group.Width * group.Assigns;
+		detectedBits += group.Detected * group.Width * group.Assigns;
+		assigns += group.Assigns;
+	}
+
+	char path[] = "/tmp/faultSamplerTestXXXXXX";
+	const int tmpFd = mkstemp(path);
+	if(0 > tmpFd)
+	{
+		sasError("mkstemp failed\n");
+		return -1;
+	}
+	close(tmpFd);
+
+	FaultSampler sampler;
+	if(sampler.Open(path))
+	{
+		sasError("Open failed\n");
+		unlink(path);
+		return -1;
+	}
+
+	const double halfWidth = 0.03;
+	const double confidence = 0.95;
+	const size_t maxExperiments = 20000;
+
+	Prng prng(randomBits());
+	while(!sampler.Done(halfWidth, confidence, 10) && (sampler.Experiments() < maxExperiments))
+	{
+		// As FiSetRTL: Draw sites uniformly over assigns until one is in the target stratum
+		const std::string target = sampler.Target();
+		const population_t * group = nullptr;
+		std::string stratum;
+		for(size_t draw = 0; draw < MaxDraws; draw++)
+		{
+			size_t assign = prng.Below(assigns);
+			for(const auto &candidate : population)
+			{
+				if(assign < candidate.Assigns)
+				{
+					group = &candidate;
+					break;
+				}
+
+				assign -= candidate.Assigns;
+			}
+
+			stratum = sampler.Stratum(group->Chain, group->Width);
+			sampler.Candidate(stratum, group->Width);
+			if(target.empty() || (target == stratum))
+			{
+				break;
+			}
+		}
+
+		const double draw = prng.Uniform();
+		sampler.Record(stratum, (draw < group->Sdc) ? outcome::Sdc :
+				(draw < group->Sdc + group->Detected) ? outcome::Detected : outcome::Masked);
+
+		if(sampler.Sync())
+		{
+			sasError("Sync failed\n");
+			unlink(path);
+			return -1;
+		}
+	}
+
+	const estimate_t sdc = sampler.Estimate(outcome::Sdc, confidence);
+	const estimate_t detected = sampler.Estimate(outcome::Detected, confidence);
+
+	// Another experiment of the campaign sees the same state
+	FaultSampler samplerOther;
+	const int openRet = samplerOther.Open(path);
+	unlink(path);
+
+	if(openRet || (samplerOther.Experiments() != sampler.Experiments()) ||
+			(samplerOther.Estimate(outcome::Sdc, confidence).Rate != sdc.Rate))
+	{
+		sasError("Log doesn't reproduce state\n");
+		return -1;
+	}
+
+	if(!sampler.Done(halfWidth, confidence, 10))
+	{
+		sasError("No early stop after %lu experiments\n", sampler.Experiments());
+		return -1;
+	}
+
+	// 2 half widths: Far beyond 95%, so the test practically never fails by chance
+	if((fabs(sdc.Rate - sdcBits / bits) > 2 * sdc.HalfWidth) ||
+			(fabs(detected.Rate - detectedBits / bits) > 2 * detected.HalfWidth))
+	{
+		sasError("Estimates SDC %f +- %f, detected %f +- %f, expected %f, %f\n",
+				sdc.Rate, sdc.HalfWidth, detected.Rate, detected.HalfWidth, sdcBits / bits, detectedBits / bits);
+		return -1;
+	}
+
+	return 0;
+}
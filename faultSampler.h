@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef FAULTSAMPLER_H_
+#define FAULTSAMPLER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Stratified sampling of RTL fault sites for a fault injection campaign.
+// Strata are module instances (leading ModuleInstanceChain entries) split by signal width class.
+// RandomFiGet draws sites uniformly over assigns, so the widths of all drawn candidates estimate
+// each stratum's share of fault bits. Outcome rates are weighted with these shares, i.e. per bit.
+// Experiments go to the stratum reducing the variance of the rate estimates most, and a campaign
+// is done once the confidence intervals of all outcome rates are narrow enough.
+//
+// The campaign state is an append-only log shared by all experiments (processes) of a campaign:
+// "C <stratum> <width> <count>" per candidate site and "R <stratum> <outcome>" per result.
+// Not thread-safe.
+
+class FaultSampler {
+public:
+	explicit FaultSampler(size_t chainDepth = 2); // chain entries distinguishing module instances
+	virtual ~FaultSampler();
+
+	FaultSampler & operator=(const FaultSampler&) = delete;
+	FaultSampler(const FaultSampler &sampler) = delete;
+
+	enum class outcome {
+		Masked,
+		Sdc, // silent data corruption
+		Detected}; // parity, residue, or protocol error raised inside RTL
+
+	static const size_t OutcomeCnt = 3;
+	static const char * OutcomeName(outcome result); // "MASKED", "SDC", "DETECTED"
+	static int OutcomeGet(const char * name, outcome * result);
+
+	std::string Stratum(const std::vector<uint16_t> &chain, size_t width) const; // e.g. "3-1/w16"
+
+	// Opens (or creates) the campaign log and reads it. Without, the state is kept in memory only
+	int Open(const char * path);
+
+	// Appends own entries to the log and reads those of other experiments
+	int Sync();
+
+	void Candidate(const std::string &stratum, size_t width); // a site drawn uniformly over assigns
+	void Record(const std::string &stratum, outcome result);
+
+	static const size_t MaxDraws = 256; // candidates drawn at most to hit the target stratum
+
+	// Stratum of the next experiment, empty if no candidates seen yet
+	std::string Target() const;
+
+	typedef struct {
+		double Rate; // per fault bit
+		double HalfWidth; // of the confidence interval
+	} estimate_t;
+
+	estimate_t Estimate(outcome result, double confidence) const;
+	size_t Experiments() const {return Experiments_;};
+
+	bool Done(double halfWidth, double confidence, size_t minExperiments) const;
+
+	static int UnitTest();
+
+private:
+	typedef struct {
+		double Bits = 0; // widths of all candidates drawn
+		size_t Experiments = 0;
+		size_t Counts[OutcomeCnt] = {};
+	} stratum_t;
+
+	const size_t ChainDepth_;
+	std::map<std::string, stratum_t> Strata_;
+	double Bits_ = 0;
+	size_t Experiments_ = 0;
+
+	// With a log, own entries are applied once read back from it
+	int Fd_ = -1;
+	size_t ReadOffset_ = 0;
+	std::string Partial_; // read, but incomplete last line
+	std::map<std::pair<std::string, size_t>, size_t> PendingCandidates_; // (stratum, width) -> count
+	std::string PendingRecords_;
+
+	int Apply(const std::string &line);
+};
+
+#endif /* FAULTSAMPLER_H_ */
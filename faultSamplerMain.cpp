@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "helpers.h"
+
+#include "faultSampler.h"
+
+// Exit code if the campaign needs more experiments
+static const int exitContinue = 2;
+
+static void usage(const char * appName)
+{
+	sasInfo("Usage: %s -f log [-r stratum -o MASKED|SDC|DETECTED] [-e half width] [-c confidence] [-m min. experiments]\n", appName);
+	sasInfo("\tRecords the outcome of an experiment (-r, -o) and prints the rate estimates.\n");
+	sasInfo("\tExits with 0 once the campaign is done, %i if it needs more experiments\n", exitContinue);
+}
+
+int main(int argc, char ** argv)
+{
+	const char * path = nullptr;
+	const char * stratum = nullptr;
+	const char * outcomeName = nullptr;
+	double halfWidth = 0.01;
+	double confidence = 0.95;
+	size_t minExperiments = 100;
+
+	int opt;
+	while(-1 != (opt = getopt(argc, argv, "f:r:o:e:c:m:h")))
+	{
+		switch(opt)
+		{
+		case 'f':
+			path = optarg;
+			break;
+
+		case 'r':
+			stratum = optarg;
+			break;
+
+		case 'o':
+			outcomeName = optarg;
+			break;
+
+		case 'e':
+			halfWidth = strtod(optarg, NULL);
+			break;
+
+		case 'c':
+			confidence = strtod(optarg, NULL);
+			break;
+
+		case 'm':
+			minExperiments = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'h':
+			usage(argv[0]);
+			return EXIT_SUCCESS;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if((nullptr == path) || ((nullptr == stratum) != (nullptr == outcomeName)))
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	FaultSampler sampler;
+	if(sampler.Open(path))
+	{
+		sasFatal("Open failed\n");
+	}
+
+	if(nullptr != stratum)
+	{
+		FaultSampler::outcome result;
+		if(FaultSampler::OutcomeGet(outcomeName, &result))
+		{
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		sampler.Record(stratum, result);
+		if(sampler.Sync())
+		{
+			sasFatal("Sync failed\n");
+		}
+	}
+
+	sasInfo("Experiments = %lu\n", sampler.Experiments());
+	for(size_t result = 0; result < FaultSampler::OutcomeCnt; result++)
+	{
+		const FaultSampler::estimate_t estimate = sampler.Estimate((FaultSampler::outcome) result, confidence);
+		sasInfo("%s = %f +- %f\n", FaultSampler::OutcomeName((FaultSampler::outcome) result), estimate.Rate, estimate.HalfWidth);
+	}
+
+	return sampler.Done(halfWidth, confidence, minExperiments) ? EXIT_SUCCESS : exitContinue;
+}
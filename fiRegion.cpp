@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "netlistFaultInjector.hpp"
+
+#include "helpers.h"
+
+// Fault sites of an FI region's netlist (see FI_REGIONS in the Makefile): Compiled per region as
+// fiRegionRandomFiGet_<region> and linked with the region's netlistFaultInjector and SystolicArrayFiSignals
+// into one object, of which only that (unmangled) function stays global. So the sites of all regions are
+// linked side by side. Draws are serialized by the caller, see netlistRandomFiGet of systolicArraySim.cpp
+extern "C" int fiRegionRandomFiGet(std::vector<uint16_t> * chain, uint32_t * assignNr, size_t * width)
+{
+	static NetlistFaultInjector * netlistFaultInjector = []()
+	{
+		auto injector = new NetlistFaultInjector;
+		if(injector->Init())
+		{
+			sasError("NetlistFaultInjector Init failed\n");
+		}
+
+		return injector;
+	}();
+
+	return netlistFaultInjector->RandomFiGet(chain, assignNr, width);
+}
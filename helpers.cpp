@@ -25,26 +25,35 @@
 size_t sasWarningCnt = 0;
 size_t sasErrorCnt = 0;
 
-uint64_t randomBits()
+std::mutex &randMutex()
 {
-	uint64_t out = 0;
-	uint8_t* outU8 = (uint8_t*) &out;
-	for(size_t byte = 0; byte < sizeof(out); byte++)
+	static std::mutex mutex;
+	return mutex;
+}
+
+Prng &threadPrng()
+{
+	static thread_local Prng prng([]()
 	{
+		std::lock_guard<std::mutex> lock(randMutex());
 		// coverity[DC.WEAK_CRYPTO]
-		outU8[byte] = rand();
-	}
+		return (((uint64_t) rand()) << 32) ^ rand();
+	}());
+	return prng;
+}
 
-	return out;
+uint64_t randomBits()
+{
+	return threadPrng().Next();
 }
 
 // Will generate random Double with exponent uniformly within given thresholds
 // And fractionZero none = 0 ... 1 = all
 double randomDouble(int expMin, int expMax, float fractionZero)
 {
-	// coverity[DC.WEAK_CRYPTO]
-	const double isZero = (double) rand();
-	if(isZero / RAND_MAX < fractionZero)
+	Prng &prng = threadPrng();
+
+	if(prng.Uniform() < fractionZero)
 	{
 		return 0;
 	}
@@ -52,8 +61,7 @@ double randomDouble(int expMin, int expMax, float fractionZero)
 	doubleUnion outU64;
 
 	// sign
-	// coverity[DC.WEAK_CRYPTO]
-	outU64.u64 = rand() % 2 ? 1 : 0;
+	outU64.u64 = prng.Next() % 2 ? 1 : 0;
 
 	// Exponent
 	outU64.u64 <<= 11;
@@ -64,8 +72,7 @@ double randomDouble(int expMin, int expMax, float fractionZero)
 	uint16_t expOffset;
 	while(1) // TODO: very dirty
 	{
-		// coverity[DC.WEAK_CRYPTO]
-		expOffset = rand() & ((1UL << clogExpDiff) - 1);
+		expOffset = prng.Next() & ((1UL << clogExpDiff) - 1);
 		if(expOffset <= expDiff)
 		{
 			break;
@@ -78,7 +85,7 @@ double randomDouble(int expMin, int expMax, float fractionZero)
 
 	// Mantissa
 	outU64.u64 <<= 52;
-	outU64.u64 |= (randomBits() & ((1UL << 52) - 1)); // Mask bits higher than 52
+	outU64.u64 |= (prng.Next() & ((1UL << 52) - 1)); // Mask bits higher than 52
 
 	return outU64.flt;
 }
@@ -101,13 +108,13 @@ void printBinary(const uint8_t * pData, size_t nBits, size_t lineBreakAfter)
 	}
 }
 
-void matrixPrint(const double * data, size_t rows, size_t cols, size_t stride)
+void matrixPrint(const double * data, size_t rows, size_t cols, size_t stride, size_t colStride)
 {
 	for(size_t row = 0; row < rows; row++)
 	{
 		for(size_t col = 0; col < cols; col++)
 		{
-			sasDebug("%f, ", data[row * stride + col]);
+			sasDebug("%f, ", data[row * stride + col * colStride]);
 		}
 		sasDebug("\n");
 	}
@@ -25,11 +25,14 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include <mutex>
 #include <vector>
 
 #include "verilated.h"
 #include "verilated_types.h"
 
+#include "prng.h"
+
 extern size_t sasWarningCnt;
 extern size_t sasErrorCnt;
 
@@ -125,8 +128,13 @@ extern double toDouble(const sNFp64_t &data);
 extern int bitsCopy(uint8_t * pData, size_t nData, size_t startBit, uint8_t* bits, uint8_t nBits);
 
 extern void printBinary(const uint8_t * pData, size_t nBits, size_t lineBreakAfter = SIZE_MAX);
-extern void matrixPrint(const double * data, size_t rows, size_t cols, size_t stride);
+extern void matrixPrint(const double * data, size_t rows, size_t cols, size_t stride, size_t colStride = 1);
+
+// rand() is process wide: Its users hold this, so one seeding with srand draws undisturbed
+extern std::mutex &randMutex();
 
+// Drawn from a per thread Prng, seeded from rand() on first use (i.e. reproducible via srand)
+extern Prng &threadPrng();
 extern uint64_t randomBits();
 extern double randomDouble(int expMin, int expMax, float fractionZero);
 
@@ -21,8 +21,13 @@
 #include <math.h>
 #include <stdlib.h>
 #include <float.h>
+#include <time.h>
+#include <getopt.h>
 
 #include <array>
+#include <atomic>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "verilated.h"
@@ -36,6 +41,10 @@
 #include "helpers.h"
 
 #include "systolicArraySim.h"
+#include "simServer.h"
+#include "faultSampler.h"
+#include "faultDictionary.h"
+#include "resultCompare.h"
 
 #ifdef VERILATED_VFMA_NETLIST_H_
 #define testBench_t VFMA_netlist
@@ -95,11 +104,19 @@ double Float(bool sign, uint8_t exp, uint32_t mant)
 	return flt.flt;
 }
 
-int UT_FMA()
-{
-	const double relDiffThr = 0.00000000008;
+static const double fmaRelDiffThr = 0.00000000008;
+static const size_t fmaClocks = 12;
+
+#ifdef NETLIST
+static const size_t fmaRandTestRunsPerRange = 10000;
+#else // !NETLIST
+static const size_t fmaRandTestRunsPerRange = 1000000;
+#endif // !NETLSIT
+
+static const size_t fmaRandTestChunks = 10; // test cases per exponent range
 
-	const size_t FMA_CLOCKS = 12;
+static int fmaExactTest()
+{
 	testBench_t tb;
 
 	std::vector<std::array<double,3>> exactTestSet = { // mult, mult, acc
@@ -171,7 +188,7 @@ int UT_FMA()
 			return -1;
 		}
 
-		for(size_t clk = 0; clk < FMA_CLOCKS; clk++)
+		for(size_t clk = 0; clk < fmaClocks; clk++)
 		{
 			tb.clk = clk % 2;
 			tb.eval();
@@ -204,37 +221,21 @@ int UT_FMA()
 		}
 	}
 
-	double maxRelDiff = 0;
+	return 0;
+}
 
-#ifdef NETLIST
-	const size_t randTestRunsPerRange = 10000;
-#else // !NETLIST
-	const size_t randTestRunsPerRange = 1000000;
-#endif // !NETLSIT
+// runs random operations with exponents within +- expRange
+static int fmaRandomTest(int expRange, size_t runs)
+{
+	testBench_t tb;
+	double maxRelDiff = 0;
 
-	for(size_t randTest = 0; randTest < 3 * randTestRunsPerRange; randTest++)
+	for(size_t testNr = 1; testNr <= runs; testNr++)
 	{
-		testNr++;
-
 		std::array<double,3> test;
-		if(randTestRunsPerRange > randTest)
-		{
-			test[0] = randomDouble(-500, 500, 0.1);
-			test[1] = randomDouble(-500, 500, 0.1);
-			test[2] = randomDouble(-500, 500, 0.1);
-		}
-		else if(2 * randTestRunsPerRange > randTest)
-		{
-			test[0] = randomDouble(-53, 53, 0.1);
-			test[1] = randomDouble(-53, 53, 0.1);
-			test[2] = randomDouble(-53, 53, 0.1);
-		}
-		else
-		{
-			test[0] = randomDouble(-5, 5, 0.1);
-			test[1] = randomDouble(-5, 5, 0.1);
-			test[2] = randomDouble(-5, 5, 0.1);
-		}
+		test[0] = randomDouble(-expRange, expRange, 0.1);
+		test[1] = randomDouble(-expRange, expRange, 0.1);
+		test[2] = randomDouble(-expRange, expRange, 0.1);
 
 #if DEBUG
 		sasInfo("#%lu: \n\t%f * %f + %f\n\n", testNr, test[0], test[1], test[2]);
@@ -246,7 +247,7 @@ int UT_FMA()
 			return -1;
 		}
 
-		for(size_t clk = 0; clk < FMA_CLOCKS; clk++)
+		for(size_t clk = 0; clk < fmaClocks; clk++)
 		{
 			tb.clk = clk % 2;
 			tb.eval();
@@ -280,11 +281,11 @@ int UT_FMA()
 			return -2;
 
 		}
-		else if((relDiff > relDiffThr) && !((0 == expected) && (0 == result)))
+		else if((relDiff > fmaRelDiffThr) && !((0 == expected) && (0 == result)))
 		{
 			sasError("TestNr %lu: %.*f * %.*f + %.*f != %.*f (= %.*f, relDiffThr = %.*f, relDiff = %.*f)\n",
 					testNr, DBL_DECIMAL_DIG, test[0], DBL_DECIMAL_DIG, test[1], DBL_DECIMAL_DIG, test[2],  DBL_DECIMAL_DIG, result,
-					DBL_DECIMAL_DIG, expected, DBL_DECIMAL_DIG, relDiffThr, DBL_DECIMAL_DIG, relDiff);
+					DBL_DECIMAL_DIG, expected, DBL_DECIMAL_DIG, fmaRelDiffThr, DBL_DECIMAL_DIG, relDiff);
 			Print(tb);
 			sasInfo("\n");
 			return -2;
@@ -295,14 +296,20 @@ int UT_FMA()
 	sasInfo("maxRelDiff = %.*f", DBL_DECIMAL_DIG, maxRelDiff);
 #endif // DEBUG
 
-	// pipeline tests
+	return 0;
+}
+
+static int fmaPipelineTest()
+{
+	testBench_t tb;
+
 	std::vector<std::array<double,3>> pipeTestSet;
 	for(size_t test = 0; test < 32; test++)
 	{
 		pipeTestSet.push_back({randomDouble(-5, 5, 0.1), randomDouble(-5, 5, 0.1), randomDouble(-5, 5, 0.1)});
 	}
 
-	for(size_t clk = 0; clk < FMA_CLOCKS - 2 + 2 * pipeTestSet.size(); clk++)
+	for(size_t clk = 0; clk < fmaClocks - 2 + 2 * pipeTestSet.size(); clk++)
 	{
 		if(0 == clk % 2)
 		{
@@ -316,13 +323,13 @@ int UT_FMA()
 		tb.clk = clk % 2;
 		tb.eval();
 
-		if((FMA_CLOCKS - 2 <= clk) && (0 == clk % 2))
+		if((fmaClocks - 2 <= clk) && (0 == clk % 2))
 		{
 			const double result = toDouble(tb.out);
-			const size_t testIndex = (clk - FMA_CLOCKS + 2) / 2;
+			const size_t testIndex = (clk - fmaClocks + 2) / 2;
 			const double expected = pipeTestSet[testIndex][0] * pipeTestSet[testIndex][1] + pipeTestSet[testIndex][2];
 			const double relError = fabs(result - expected) / fabs(expected);
-			if(relError > relDiffThr)
+			if(relError > fmaRelDiffThr)
 			{
 				sasError("Pipeline Test: Got %f, expected %f\n", result, expected);
 				return -1;
@@ -333,22 +340,160 @@ int UT_FMA()
 	return 0;
 }
 
-int main()
+typedef SystolicArraySim::unitTestCase_t testCase_t;
+
+static void fmaTestCases(std::vector<testCase_t> * cases)
+{
+	cases->push_back({"FMA exact", fmaExactTest});
+
+	for(const int expRange : {500, 53, 5})
+	{
+		for(size_t chunk = 0; chunk < fmaRandTestChunks; chunk++)
+		{
+			const size_t runs = fmaRandTestRunsPerRange / fmaRandTestChunks;
+			cases->push_back({"FMA random " + std::to_string(expRange) + " #" + std::to_string(chunk),
+					[expRange, runs]() {return fmaRandomTest(expRange, runs);}});
+		}
+	}
+
+	cases->push_back({"FMA pipeline", fmaPipelineTest});
+}
+
+// Runs every shardCnt-th case, starting at shard, on jobs threads. Case c draws from threadPrng()
+// seeded with seed + c, so it gets the same operands whichever shard, job count or thread runs it
+static size_t casesRun(const std::vector<testCase_t> &cases, size_t shard, size_t shardCnt, size_t jobs, uint64_t seed)
+{
+	std::atomic<size_t> next(shard);
+	std::atomic<size_t> failedCnt(0);
+
+	auto worker = [&]()
+	{
+		for(size_t c = next.fetch_add(shardCnt); c < cases.size(); c = next.fetch_add(shardCnt))
+		{
+			threadPrng().Seed(seed + c);
+			if(cases[c].Run())
+			{
+				sasError("%s failed (case %lu)\n", cases[c].Name.c_str(), c);
+				failedCnt++;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for(size_t job = 1; job < jobs; job++)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+
+	for(auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	return failedCnt;
+}
+
+static void usage(const char * appName)
+{
+	sasInfo("Usage: %s [--shard i/n] [--jobs j] [--seed s] [--coi FMA instances]\n", appName);
+	sasInfo("\t--shard i/n: Runs every n-th test case starting at i (0 <= i < n), default 0/1\n");
+	sasInfo("\t--jobs j: Runs the cases on j threads, default: hardware threads\n");
+	sasInfo("\t--seed s: Base seed of the cases' random draws, default: random (printed)\n");
+	sasInfo("\t--coi FMA instances: Comma separated, enables the cone of influence simulation (NETLIST builds),\n");
+	sasInfo("\t\tsee SystolicArraySim::CoiEnable. Without, CoiTest is skipped\n");
+}
+
+int main(int argc, char ** argv)
 {
 	srand(time(NULL));
 
-	sasInfo("FMA UT:\n");
-	if(UT_FMA())
+	size_t shard = 0;
+	size_t shardCnt = 1;
+	size_t jobs = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+	uint64_t seed = randomBits();
+	std::vector<uint16_t> fmaInstances;
+
+	const struct option longOptions[] = {
+			{"shard", required_argument, nullptr, 's'},
+			{"jobs", required_argument, nullptr, 'j'},
+			{"seed", required_argument, nullptr, 'r'},
+			{"coi", required_argument, nullptr, 'c'},
+			{"help", no_argument, nullptr, 'h'},
+			{nullptr, 0, nullptr, 0}};
+
+	int opt;
+	while(-1 != (opt = getopt_long(argc, argv, "s:j:r:c:h", longOptions, nullptr)))
 	{
-		sasFatal("UT_FMA failed\n");
+		switch(opt)
+		{
+		case 's':
+			if((2 != sscanf(optarg, "%lu/%lu", &shard, &shardCnt)) || (shard >= shardCnt))
+			{
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+
+		case 'j':
+			jobs = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'r':
+			seed = strtoull(optarg, NULL, 0);
+			break;
+
+		case 'c':
+			for(const char * pos = optarg; '\0' != *pos; pos += (',' == *pos) ? 1 : 0)
+			{
+				char * end;
+				fmaInstances.push_back(strtoul(pos, &end, 0));
+				if((end == pos) || ((',' != *end) && ('\0' != *end)))
+				{
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+
+				pos = end;
+			}
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
 	}
-	sasInfo("\tSuccess\n");
 
-	sasInfo("SystolicArray UT:\n");
-	SystolicArraySim saSim;
-	if(saSim.UnitTest())
+	if(0 == jobs)
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Before the cases, it applies to all instances
+	if(!fmaInstances.empty() && SystolicArraySim::CoiEnable(fmaInstances))
+	{
+		sasFatal("CoiEnable failed\n");
+	}
+
+	std::vector<testCase_t> cases;
+	fmaTestCases(&cases);
+
+	for(auto &testCase : SystolicArraySim::UnitTestCases())
+	{
+		cases.push_back(std::move(testCase));
+	}
+
+	cases.push_back({"SimServer UT", SimServer::UnitTest});
+	cases.push_back({"FaultSampler UT", FaultSampler::UnitTest});
+	cases.push_back({"FaultDictionary UT", FaultDictionary::UnitTest});
+	cases.push_back({"ResultCompare UT", ResultCompare::UnitTest});
+
+	sasInfo("Running shard %lu/%lu of %lu test cases on %lu threads, seed %lu\n", shard, shardCnt, cases.size(), jobs, seed);
+	const size_t failedCnt = casesRun(cases, shard, shardCnt, jobs, seed);
+	if(failedCnt)
 	{
-		sasFatal("UnitTest failed\n");
+		sasFatal("%lu test cases failed\n", failedCnt);
 	}
 	sasInfo("\tSuccess\n");
 
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef PRNG_H_
+#define PRNG_H_
+
+#include <stdint.h>
+
+// xoshiro256** generator: Unlike rand() it has no global state (and lock), so every simulator
+// instance or thread owns one and its draws are reproducible from the seed alone.
+// Not suitable for cryptography.
+class Prng {
+public:
+	explicit Prng(uint64_t seed = 0) {Seed(seed);};
+
+	// Expands seed with splitmix64, so similar seeds (e.g. seed + rank) give unrelated streams
+	void Seed(uint64_t seed)
+	{
+		for(uint64_t &state : State_)
+		{
+			seed += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			state = z ^ (z >> 31);
+		}
+	};
+
+	uint64_t Next()
+	{
+		const uint64_t result = Rotl(State_[1] * 5, 7) * 9;
+		const uint64_t t = State_[1] << 17;
+
+		State_[2] ^= State_[0];
+		State_[3] ^= State_[1];
+		State_[1] ^= State_[2];
+		State_[0] ^= State_[3];
+
+		State_[2] ^= t;
+		State_[3] = Rotl(State_[3], 45);
+
+		return result;
+	};
+
+	// Uniform in [0, bound), bound > 0. Modulo bias is negligible for the small bounds used here
+	uint64_t Below(uint64_t bound) {return Next() % bound;};
+
+	// Uniform in [0, 1)
+	double Uniform() {return (Next() >> 11) * (1.0 / (1ULL << 53));};
+
+private:
+	uint64_t State_[4];
+
+	static uint64_t Rotl(uint64_t x, int k) {return (x << k) | (x >> (64 - k));};
+};
+
+#endif /* PRNG_H_ */
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include <algorithm>
+
+#include "helpers.h"
+
+#include "resultCompare.h"
+
+static uint64_t bitsGet(double val)
+{
+	uint64_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+	return bits;
+}
+
+// Doubles as integers in the order of their values, -0 and +0 alike
+static int64_t orderedGet(double val)
+{
+	const int64_t bits = (int64_t) bitsGet(val);
+	return (0 > bits) ? INT64_MIN - bits : bits;
+}
+
+ResultCompare::ResultCompare()
+{
+}
+
+ResultCompare::~ResultCompare()
+{
+}
+
+size_t ResultCompare::UlpBin(double golden, double faulty)
+{
+	const int64_t orderedGolden = orderedGet(golden);
+	const int64_t orderedFaulty = orderedGet(faulty);
+	const uint64_t distance = (orderedGolden > orderedFaulty) ?
+			(uint64_t) orderedGolden - (uint64_t) orderedFaulty : (uint64_t) orderedFaulty - (uint64_t) orderedGolden;
+
+	return (0 == distance) ? 0 : 64 - __builtin_clzll(distance);
+}
+
+bool ResultCompare::Corrupted(size_t row, size_t col) const
+{
+	const size_t pos = row * ColCnt_ + col;
+	return 0 != (Corrupted_[pos / 64] & (1ull << (pos % 64)));
+}
+
+void ResultCompare::Compare(const double * golden, size_t goldenRowStride, size_t goldenColStride,
+		const double * faulty, size_t faultyRowStride, size_t faultyColStride, size_t rowCnt, size_t colCnt)
+{
+	ColCnt_ = colCnt;
+	CorruptedCnt_ = 0;
+	Corrupted_.assign((rowCnt * colCnt + 63) / 64, 0);
+	MaxAbsError_ = 0;
+	MaxRelError_ = 0;
+	UlpHist_.fill(0);
+	NanCnt_ = 0;
+	InfCnt_ = 0;
+
+	// Along the dimension contiguous in both matrices, if any
+	if((1 == goldenColStride) && (1 == faultyColStride))
+	{
+		for(size_t row = 0; row < rowCnt; row++)
+		{
+			Run<true>(golden + row * goldenRowStride, 1, faulty + row * faultyRowStride, 1, colCnt, row * colCnt, 1);
+		}
+	}
+	else if((1 == goldenRowStride) && (1 == faultyRowStride))
+	{
+		for(size_t col = 0; col < colCnt; col++)
+		{
+			Run<true>(golden + col * goldenColStride, 1, faulty + col * faultyColStride, 1, rowCnt, col, colCnt);
+		}
+	}
+	else
+	{
+		for(size_t row = 0; row < rowCnt; row++)
+		{
+			Run<false>(golden + row * goldenRowStride, goldenColStride, faulty + row * faultyRowStride, faultyColStride,
+					colCnt, row * colCnt, 1);
+		}
+	}
+}
+
+// Compares cnt elements, at position pos + elem * posStride. Contiguous: Strides are 1, so the
+// block scan compiles to vector loads and compares
+template <bool contiguous>
+void ResultCompare::Run(const double * golden, size_t goldenStride, const double * faulty, size_t faultyStride,
+		size_t cnt, size_t pos, size_t posStride)
+{
+	if(contiguous)
+	{
+		goldenStride = 1;
+		faultyStride = 1;
+	}
+
+	for(size_t block = 0; block < cnt; block += BlockElems)
+	{
+		const size_t blockEnd = std::min(block + BlockElems, cnt);
+
+		uint64_t diff = 0;
+		for(size_t elem = block; elem < blockEnd; elem++)
+		{
+			diff |= bitsGet(golden[elem * goldenStride]) ^ bitsGet(faulty[elem * faultyStride]);
+		}
+
+		if(0 == diff)
+		{
+			continue;
+		}
+
+		for(size_t elem = block; elem < blockEnd; elem++)
+		{
+			if(bitsGet(golden[elem * goldenStride]) != bitsGet(faulty[elem * faultyStride]))
+			{
+				ElementCompare(golden[elem * goldenStride], faulty[elem * faultyStride], pos + elem * posStride);
+			}
+		}
+	}
+}
+
+void ResultCompare::ElementCompare(double golden, double faulty, size_t pos)
+{
+	CorruptedCnt_++;
+	Corrupted_[pos / 64] |= 1ull << (pos % 64);
+
+	NanCnt_ += std::isnan(faulty) ? 1 : 0;
+	InfCnt_ += std::isinf(faulty) ? 1 : 0;
+
+	const double absError = fabs(faulty - golden);
+	const double relError = (std::isnan(absError) || (0 != golden)) ? absError / fabs(golden) : ((0 != absError) ? INFINITY : 0);
+
+	// NaN sticks: std::max keeps its first argument if unordered
+	MaxAbsError_ = std::isnan(absError) ? absError : std::max(MaxAbsError_, absError);
+	MaxRelError_ = std::isnan(relError) ? relError : std::max(MaxRelError_, relError);
+
+	if(!std::isnan(golden) && !std::isnan(faulty))
+	{
+		UlpHist_[UlpBin(golden, faulty)]++;
+	}
+}
+
+// The same corruptions are found in row major, column major and strided layouts
+int ResultCompare::UnitTest()
+{
+	const size_t rowCnt = 5;
+	const size_t colCnt = 37; // rows span several blocks, the last one partial
+
+	std::vector<double> golden(rowCnt * colCnt);
+	for(double &elem : golden)
+	{
+		elem = randomDouble(-5, 5, 0);
+	}
+	golden[2 * colCnt + 17] = 0;
+
+	std::vector<double> faulty = golden;
+	uint64_t bits = bitsGet(faulty[1 * colCnt + 3]) ^ 1;
+	memcpy(&faulty[1 * colCnt + 3], &bits, sizeof(bits));
+	faulty[2 * colCnt + 17] = -0.0;
+	faulty[0 * colCnt + 20] = INFINITY;
+	faulty[4 * colCnt + 36] = NAN;
+
+	// Row major, column major, and strided with padding
+	const size_t pad = 3;
+	std::vector<double> goldenT(rowCnt * colCnt);
+	std::vector<double> faultyT(rowCnt * colCnt);
+	std::vector<double> faultyStrided(rowCnt * (2 * colCnt + pad));
+	for(size_t row = 0; row < rowCnt; row++)
+	{
+		for(size_t col = 0; col < colCnt; col++)
+		{
+			goldenT[col * rowCnt + row] = golden[row * colCnt + col];
+			faultyT[col * rowCnt + row] = faulty[row * colCnt + col];
+			faultyStrided[row * (2 * colCnt + pad) + 2 * col] = faulty[row * colCnt + col];
+		}
+	}
+
+	ResultCompare compare;
+	for(size_t layout = 0; layout < 3; layout++)
+	{
+		switch(layout)
+		{
+		case 0:
+			compare.Compare(golden.data(), colCnt, 1, faulty.data(), colCnt, 1, rowCnt, colCnt);
+			break;
+
+		case 1:
+			compare.Compare(goldenT.data(), 1, rowCnt, faultyT.data(), 1, rowCnt, rowCnt, colCnt);
+			break;
+
+		default:
+			compare.Compare(golden.data(), colCnt, 1, faultyStrided.data(), 2 * colCnt + pad, 2, rowCnt, colCnt);
+			break;
+		}
+
+		size_t histCnt = 0;
+		for(const size_t cnt : compare.UlpHist())
+		{
+			histCnt += cnt;
+		}
+
+		if((4 != compare.CorruptedCnt()) || !compare.Corrupted(1, 3) || !compare.Corrupted(2, 17) ||
+				!compare.Corrupted(0, 20) || !compare.Corrupted(4, 36) || compare.Corrupted(4, 35))
+		{
+			sasError("Layout %lu: Unexpected corrupted elements\n", layout);
+			return -1;
+		}
+
+		if((1 != compare.NanCnt()) || (1 != compare.InfCnt()) || !std::isnan(compare.MaxAbsError()) ||
+				!std::isnan(compare.MaxRelError()) || (3 != histCnt) || (1 != compare.UlpHist()[0]) || (1 != compare.UlpHist()[1]))
+		{
+			sasError("Layout %lu: Unexpected statistics\n", layout);
+			return -1;
+		}
+	}
+
+	// Statistics are those of the last compare
+	compare.Compare(golden.data(), colCnt, 1, golden.data(), colCnt, 1, rowCnt, colCnt);
+	if((0 != compare.CorruptedCnt()) || (0 != compare.MaxAbsError()) || (0 != compare.MaxRelError()) || compare.Corrupted(1, 3))
+	{
+		sasError("Identical matrices compared as corrupted\n");
+		return -1;
+	}
+
+	if((UlpBin(1.0, nextafter(1.0, 2.0)) != 1) || (UlpBin(-DBL_TRUE_MIN, DBL_TRUE_MIN) != 2) || (UlpBin(1.0, 1.0 + 1e-15) != 3))
+	{
+		sasError("Unexpected ULP bins\n");
+		return -1;
+	}
+
+	return 0;
+}
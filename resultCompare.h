@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef RESULTCOMPARE_H_
+#define RESULTCOMPARE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <array>
+#include <vector>
+
+// Compares a faulty output matrix to the golden (fault free) one in a single pass, for classifying
+// the outcome of fault injection experiments. Elements are corrupted if their bits differ: Masked
+// faults give bit identical results, so the pass is a vectorized bitwise scan, and only blocks
+// holding corrupted elements are looked at element by element. Both matrices are addressed with
+// row and column strides (row major: colStride 1, column major: rowStride 1), positions are row major.
+// An instance keeps the statistics of the last Compare and reuses its memory. Not thread-safe.
+
+class ResultCompare {
+public:
+	ResultCompare();
+	virtual ~ResultCompare();
+
+	ResultCompare & operator=(const ResultCompare&) = delete;
+	ResultCompare(const ResultCompare &compare) = delete;
+
+	// Bin 0: distance 0 (+0 vs. -0), bin b: ULP distance in [2^(b-1), 2^b)
+	static const size_t UlpBins = 65;
+
+	void Compare(const double * golden, size_t goldenRowStride, size_t goldenColStride,
+			const double * faulty, size_t faultyRowStride, size_t faultyColStride, size_t rowCnt, size_t colCnt);
+
+	size_t CorruptedCnt() const {return CorruptedCnt_;};
+	bool Corrupted(size_t row, size_t col) const;
+	const std::vector<uint64_t> &CorruptedBitmap() const {return Corrupted_;}; // bit row * colCnt + col
+
+	// NaN if a corrupted element is NaN. Rel. error of a golden 0 is Inf (0 for -0 vs. +0)
+	double MaxAbsError() const {return MaxAbsError_;};
+	double MaxRelError() const {return MaxRelError_;};
+
+	// Of the corrupted elements without NaN on either side
+	const std::array<size_t, UlpBins> &UlpHist() const {return UlpHist_;};
+	static size_t UlpBin(double golden, double faulty);
+
+	size_t NanCnt() const {return NanCnt_;}; // corrupted elements NaN in faulty
+	size_t InfCnt() const {return InfCnt_;}; // corrupted elements +-Inf in faulty
+
+	static int UnitTest();
+
+private:
+	static const size_t BlockElems = 16; // compared at once, before looking at single elements
+
+	size_t ColCnt_ = 0;
+	size_t CorruptedCnt_ = 0;
+	std::vector<uint64_t> Corrupted_;
+	double MaxAbsError_ = 0;
+	double MaxRelError_ = 0;
+	std::array<size_t, UlpBins> UlpHist_ = {};
+	size_t NanCnt_ = 0;
+	size_t InfCnt_ = 0;
+
+	template <bool contiguous>
+	void Run(const double * golden, size_t goldenStride, const double * faulty, size_t faultyStride,
+			size_t cnt, size_t pos, size_t posStride);
+	void ElementCompare(double golden, double faulty, size_t pos);
+};
+
+#endif /* RESULTCOMPARE_H_ */
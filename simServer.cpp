@@ -0,0 +1,1026 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <new>
+#include <algorithm>
+#include <string>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "helpers.h"
+
+#include "simServer.h"
+
+const char * const SimServer::DefaultName = "/hdfit_simserver";
+
+static const uint32_t shmMagic = 0x48444649; // "HDFI"
+static const uint32_t shmVersion = 4;
+static const size_t shmPageSize = 4096;
+static const size_t shmCacheLineSize = 64;
+static const long shmPollNs = 100000000; // clients check the server (and dead clients) every 100 ms while waiting
+
+// Free -> Claimed (client fills operands) -> Submitted -> Running -> Done -> Free
+enum class slotState : uint32_t {
+	Free,
+	Claimed,
+	Submitted,
+	Running,
+	Done};
+
+typedef struct {
+	uint32_t Magic;
+	uint32_t Version;
+	size_t SlotCnt;
+	size_t SlotSize; // bytes, incl. shmSlot_t
+	size_t MaxM; // operand buffer sizes of each slot
+	size_t MaxK;
+	size_t MaxN;
+	size_t Mmma; // server geometry, clients must match
+	size_t Kmma;
+	size_t Nmma;
+	size_t Mtile;
+	size_t Ntile;
+	char FiRegion[64]; // of the simulated netlist, clients must match
+	sem_t FreeSem; // counts free slots
+	sem_t SubmitSem; // counts submitted slots, also posted to wake workers on shutdown
+	std::atomic<uint32_t> Shutdown;
+	pid_t ServerPid; // clients stop waiting once it's gone
+} shmHeader_t;
+
+// Followed by A (MaxM x MaxK), B (MaxK x MaxN) and C (MaxM x MaxN)
+typedef struct {
+	std::atomic<slotState> State;
+	std::atomic<int32_t> ClientPid; // holding the slot, 0 if unknown. Slots of dead clients are reclaimed
+	sem_t DoneSem;
+	SimServer::job_t Job;
+	SimServer::fault_t Fault;
+	int32_t Ret;
+	bool ErrorDetected;
+} shmSlot_t;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory requires lock free atomics");
+static_assert(std::atomic<slotState>::is_always_lock_free, "Shared memory requires lock free atomics");
+static_assert(std::atomic<int32_t>::is_always_lock_free, "Shared memory requires lock free atomics");
+
+static size_t roundUp(size_t value, size_t multiple)
+{
+	return ((value + multiple - 1) / multiple) * multiple;
+}
+
+static shmSlot_t * slotGet(void * shm, size_t slot)
+{
+	const shmHeader_t * header = (const shmHeader_t *) shm;
+	return (shmSlot_t *) ((uint8_t *) shm + roundUp(sizeof(shmHeader_t), shmPageSize) + slot * header->SlotSize);
+}
+
+static double * slotMatA(const shmHeader_t * header, shmSlot_t * slot)
+{
+	return (double *) ((uint8_t *) slot + roundUp(sizeof(shmSlot_t), shmCacheLineSize));
+}
+
+static double * slotMatB(const shmHeader_t * header, shmSlot_t * slot)
+{
+	return slotMatA(header, slot) + header->MaxM * header->MaxK;
+}
+
+static double * slotMatC(const shmHeader_t * header, shmSlot_t * slot)
+{
+	return slotMatB(header, slot) + header->MaxK * header->MaxN;
+}
+
+static size_t maxOutM(const SystolicArraySim &saSim)
+{
+	return std::max(saSim.Mtile(), saSim.RequiredOutPositionsBetweenK() * saSim.Mmma());
+}
+
+static size_t maxOutN(const SystolicArraySim &saSim)
+{
+	return std::max(saSim.Ntile(), saSim.RequiredOutPositionsBetweenK() * saSim.Nmma());
+}
+
+// Retries if interrupted by a signal
+static int semWait(sem_t * sem)
+{
+	while(sem_wait(sem))
+	{
+		if(EINTR != errno)
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// Unknown (0) or existing processes count as alive, also those we may not signal
+static bool processAlive(pid_t pid)
+{
+	return (0 == pid) || (0 == kill(pid, 0)) || (ESRCH != errno);
+}
+
+// Waits on sem, retrying if interrupted by a signal. Every shmPollNs, giveUp decides whether
+// to stop waiting (returns -2)
+static int semWaitPoll(sem_t * sem, const std::function<bool()> &giveUp)
+{
+	while(true)
+	{
+		timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_nsec += shmPollNs;
+		if(1000000000 <= deadline.tv_nsec)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+
+		if(0 == sem_timedwait(sem, &deadline))
+		{
+			return 0;
+		}
+
+		if((EINTR != errno) && (ETIMEDOUT != errno))
+		{
+			return -1;
+		}
+
+		if((ETIMEDOUT == errno) && giveUp())
+		{
+			return -2;
+		}
+	}
+}
+
+// Permanent faults are kept on a worker's instance if equal. Compared by field, as padding
+// and Chain entries beyond ChainLen are undefined
+static bool faultEqual(const SimServer::fault_t &a, const SimServer::fault_t &b)
+{
+	return (a.Mode == b.Mode) && (a.Csim.Place == b.Csim.Place) && (a.Csim.Corruption == b.Csim.Corruption) &&
+			(a.Csim.Mode == b.Csim.Mode) && (a.Csim.BitPos == b.Csim.BitPos) && (a.Csim.Row == b.Csim.Row) &&
+			(a.Csim.Fma == b.Csim.Fma) && (a.Csim.Input == b.Csim.Input) && (a.Csim.Site == b.Csim.Site) && (a.Csim.SiteBit == b.Csim.SiteBit) &&
+			(a.Csim.SitePattern == b.Csim.SitePattern) &&
+			(a.AssignUUID == b.AssignUUID) && (a.BitPos == b.BitPos) && (a.ChainLen == b.ChainLen) &&
+			std::equal(a.Chain, a.Chain + std::min((size_t) a.ChainLen, SimServer::MaxChainLen), b.Chain);
+}
+
+int SimServer::FaultFromRTL(fault_t * fault, const SystolicArraySim::faultRTL_t &faultRTL)
+{
+	if(MaxChainLen < faultRTL.ModuleInstanceChain.size())
+	{
+		sasError("ModuleInstanceChain too long (%lu)\n", faultRTL.ModuleInstanceChain.size());
+		return -1;
+	}
+
+	fault->Mode = faultRTL.Mode;
+	fault->AssignUUID = faultRTL.AssignUUID;
+	fault->BitPos = faultRTL.BitPos;
+	fault->ChainLen = faultRTL.ModuleInstanceChain.size();
+	std::copy(faultRTL.ModuleInstanceChain.begin(), faultRTL.ModuleInstanceChain.end(), fault->Chain);
+
+	return 0;
+}
+
+SystolicArraySim::faultRTL_t SimServer::FaultToRTL(const fault_t &fault)
+{
+	SystolicArraySim::faultRTL_t faultRTL;
+	faultRTL.Mode = fault.Mode;
+	faultRTL.AssignUUID = fault.AssignUUID;
+	faultRTL.BitPos = fault.BitPos;
+	faultRTL.ModuleInstanceChain.assign(fault.Chain, fault.Chain + std::min((size_t) fault.ChainLen, MaxChainLen));
+
+	return faultRTL;
+}
+
+SimServer::SimServer()
+{
+}
+
+SimServer::~SimServer()
+{
+	if(nullptr != Shm_)
+	{
+		munmap(Shm_, ShmSize_);
+		shm_unlink(Name_);
+	}
+}
+
+int SimServer::Create(const char * name, size_t slotCnt, size_t maxK, const char * fiRegion)
+{
+	if(nullptr != Shm_)
+	{
+		sasError("Already created\n");
+		return -1;
+	}
+
+	if((0 == slotCnt) || (0 == maxK) || (sizeof(Name_) <= strlen(name)))
+	{
+		sasError("Invalid arguments\n");
+		return -1;
+	}
+
+	// Geometry and FI region of the simulated instances
+	SystolicArraySim saSim;
+	if((nullptr != fiRegion) && saSim.FiRegionSet(fiRegion))
+	{
+		sasError("FiRegionSet failed\n");
+		return -1;
+	}
+
+	if(sizeof(shmHeader_t::FiRegion) <= strlen(saSim.FiRegion()))
+	{
+		sasError("FI region name %s too long\n", saSim.FiRegion());
+		return -1;
+	}
+
+	const size_t maxM = maxOutM(saSim);
+	const size_t maxN = maxOutN(saSim);
+
+	const size_t slotSize = roundUp(roundUp(sizeof(shmSlot_t), shmCacheLineSize) +
+			(maxM * maxK + maxK * maxN + maxM * maxN) * sizeof(double), shmPageSize);
+	const size_t shmSize = roundUp(sizeof(shmHeader_t), shmPageSize) + slotCnt * slotSize;
+
+	// Remove what a crashed server may have left behind
+	shm_unlink(name);
+	errno = 0;
+
+	const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+	if(0 > fd)
+	{
+		sasError("shm_open %s failed\n", name);
+		return -2;
+	}
+
+	if(ftruncate(fd, shmSize))
+	{
+		sasError("ftruncate failed\n");
+		close(fd);
+		shm_unlink(name);
+		return -2;
+	}
+
+	void * shm = mmap(NULL, shmSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(MAP_FAILED == shm)
+	{
+		sasError("mmap failed\n");
+		shm_unlink(name);
+		return -2;
+	}
+
+	shmHeader_t * header = (shmHeader_t *) shm;
+	header->SlotCnt = slotCnt;
+	header->SlotSize = slotSize;
+	header->MaxM = maxM;
+	header->MaxK = maxK;
+	header->MaxN = maxN;
+	header->Mmma = saSim.Mmma();
+	header->Kmma = saSim.Kmma();
+	header->Nmma = saSim.Nmma();
+	header->Mtile = saSim.Mtile();
+	header->Ntile = saSim.Ntile();
+	strcpy(header->FiRegion, saSim.FiRegion());
+	new (&header->Shutdown) std::atomic<uint32_t>(0);
+	header->ServerPid = getpid();
+
+	if(sem_init(&header->FreeSem, 1, slotCnt) || sem_init(&header->SubmitSem, 1, 0))
+	{
+		sasError("sem_init failed\n");
+		munmap(shm, shmSize);
+		shm_unlink(name);
+		return -3;
+	}
+
+	for(size_t slot = 0; slot < slotCnt; slot++)
+	{
+		shmSlot_t * shmSlot = slotGet(shm, slot);
+		new (&shmSlot->State) std::atomic<slotState>(slotState::Free);
+		new (&shmSlot->ClientPid) std::atomic<int32_t>(0);
+		if(sem_init(&shmSlot->DoneSem, 1, 0))
+		{
+			sasError("sem_init failed\n");
+			munmap(shm, shmSize);
+			shm_unlink(name);
+			return -3;
+		}
+	}
+
+	// Magic last, so clients never accept a partially initialized header
+	header->Version = shmVersion;
+	std::atomic_thread_fence(std::memory_order_release);
+	header->Magic = shmMagic;
+
+	Shm_ = shm;
+	ShmSize_ = shmSize;
+	strcpy(Name_, name);
+
+	return 0;
+}
+
+int SimServer::Run(size_t workerCnt)
+{
+	if(nullptr == Shm_)
+	{
+		sasError("Create first\n");
+		return -1;
+	}
+
+	if(0 == workerCnt)
+	{
+		sasError("Invalid arguments\n");
+		return -1;
+	}
+
+	WorkerCnt_ = workerCnt;
+
+	std::atomic<int> workerRet(0);
+	std::vector<std::thread> workers;
+	for(size_t worker = 0; worker < workerCnt; worker++)
+	{
+		workers.emplace_back([this, &workerRet]()
+		{
+			if(const int ret = Worker())
+			{
+				workerRet = ret;
+			}
+		});
+	}
+
+	for(std::thread & worker : workers)
+	{
+		worker.join();
+	}
+
+	// Jobs no worker took fail, so their clients don't wait for them. Clients withdraw jobs submitted after
+	shmHeader_t * header = (shmHeader_t *) Shm_;
+	for(size_t slot = 0; slot < header->SlotCnt; slot++)
+	{
+		shmSlot_t * shmSlot = slotGet(Shm_, slot);
+		slotState expected = slotState::Submitted;
+		if(shmSlot->State.compare_exchange_strong(expected, slotState::Running, std::memory_order_acquire))
+		{
+			shmSlot->Ret = -9;
+			shmSlot->ErrorDetected = false;
+			shmSlot->State.store(slotState::Done, std::memory_order_release);
+			sem_post(&shmSlot->DoneSem);
+		}
+	}
+
+	return workerRet;
+}
+
+void SimServer::Stop()
+{
+	if(nullptr == Shm_)
+	{
+		return;
+	}
+
+	shmHeader_t * header = (shmHeader_t *) Shm_;
+	header->Shutdown = 1;
+
+	// Wake all workers
+	for(size_t worker = 0; worker < WorkerCnt_; worker++)
+	{
+		sem_post(&header->SubmitSem);
+	}
+}
+
+int SimServer::Worker()
+{
+	shmHeader_t * header = (shmHeader_t *) Shm_;
+
+	// Warm instance, kept with its fault set as long as consecutive jobs carry the same permanent fault
+	SystolicArraySim saSim;
+	bool faultSet = false;
+	bool faultRtl = false; // set with FiSetRTL, else FiSetCsim
+	fault_t faultCurrent = {};
+
+	if(saSim.FiRegionSet(header->FiRegion))
+	{
+		sasError("FiRegionSet failed\n");
+		return -1;
+	}
+
+	while(true)
+	{
+		if(semWait(&header->SubmitSem))
+		{
+			sasError("sem_wait failed\n");
+			return -1;
+		}
+
+		if(header->Shutdown)
+		{
+			return 0;
+		}
+
+		// Claim a submitted slot, there is at least one per post unless withdrawn at shutdown
+		shmSlot_t * shmSlot = nullptr;
+		while(nullptr == shmSlot)
+		{
+			if(header->Shutdown)
+			{
+				return 0;
+			}
+
+			for(size_t slot = 0; slot < header->SlotCnt; slot++)
+			{
+				slotState expected = slotState::Submitted;
+				if(slotGet(Shm_, slot)->State.compare_exchange_strong(expected, slotState::Running, std::memory_order_acquire))
+				{
+					shmSlot = slotGet(Shm_, slot);
+					break;
+				}
+			}
+		}
+
+		const job_t job = shmSlot->Job;
+		fault_t * fault = &shmSlot->Fault;
+		shmSlot->Ret = 0;
+		shmSlot->ErrorDetected = false;
+		saSim.Seed(job.Seed);
+
+		const bool permanent = SystolicArraySim::fiMode::Permanent == fault->Mode;
+		const bool transient = SystolicArraySim::fiMode::Transient == fault->Mode;
+		const bool faultKeep = faultSet && permanent && (faultRtl == job.Rtl) && faultEqual(faultCurrent, *fault);
+
+		if(faultSet && !faultKeep)
+		{
+			if(faultRtl ? saSim.FiResetRTL() : saSim.FiResetCsim())
+			{
+				sasError("FiReset failed\n");
+				shmSlot->Ret = -2;
+			}
+
+			faultSet = false;
+		}
+
+		if((0 == shmSlot->Ret) && permanent && !faultKeep)
+		{
+			if(job.Rtl ? saSim.FiSetRTL(FaultToRTL(*fault)) : saSim.FiSetCsim(fault->Csim))
+			{
+				sasError("FiSet failed\n");
+				shmSlot->Ret = -3;
+			}
+			else
+			{
+				faultSet = true;
+				faultRtl = job.Rtl;
+				faultCurrent = *fault;
+			}
+		}
+
+		if((0 == shmSlot->Ret) && ((job.M > header->MaxM) || (job.K > header->MaxK) || (job.N > header->MaxN) ||
+				(0 == job.KCnt) || (0 != job.K % job.KCnt)))
+		{
+			sasError("Invalid job\n");
+			shmSlot->Ret = -4;
+		}
+
+		const double * matA = slotMatA(header, shmSlot);
+		const double * matB = slotMatB(header, shmSlot);
+		double * matC = slotMatC(header, shmSlot);
+
+		for(size_t sum = 0; (0 == shmSlot->Ret) && (sum < job.K); sum += job.KCnt)
+		{
+			SystolicArraySim::job_t saJob = {
+					matA + sum, job.K,
+					matB + sum * job.N, job.N,
+					matC, job.N};
+
+			if(job.TileEn ? saSim.DispatchTile(saJob) : saSim.DispatchMma(saJob, job.MmaPositionsM, job.MmaPositionsN))
+			{
+				sasError("Dispatch failed\n");
+				shmSlot->Ret = -5;
+			}
+		}
+
+		// Transient fault is chosen within the dispatched jobs and returned to the client
+		if((0 == shmSlot->Ret) && transient)
+		{
+			if(job.Rtl)
+			{
+				const SystolicArraySim::faultRTL_t faultRTL = saSim.FiSetRTL(SystolicArraySim::fiMode::Transient);
+				if((SystolicArraySim::fiMode::None == faultRTL.Mode) || FaultFromRTL(fault, faultRTL))
+				{
+					sasError("FiSetRTL failed\n");
+					shmSlot->Ret = -6;
+				}
+
+				fault->Cycle = saSim.FaultRTLCycle();
+			}
+			else
+			{
+				const SystolicArraySim::faultCsim_t faultCsim = saSim.FiSetCsim(
+						fault->Csim.Place, fault->Bits, fault->Csim.Corruption, SystolicArraySim::fiMode::Transient);
+				if(SystolicArraySim::fiCsimPlace::None == faultCsim.Place)
+				{
+					sasError("FiSetCsim failed\n");
+					shmSlot->Ret = -6;
+				}
+
+				fault->Csim = faultCsim;
+				fault->Cycle = saSim.FaultCsimCycle();
+			}
+
+			faultSet = (0 == shmSlot->Ret);
+			faultRtl = job.Rtl;
+		}
+
+		if((0 == shmSlot->Ret) && (job.Rtl ? saSim.ExecRtl(true) : saSim.ExecCsim()))
+		{
+			sasError("Exec failed\n");
+			shmSlot->Ret = -7;
+		}
+
+		shmSlot->ErrorDetected = saSim.ErrorDetected();
+
+		if(transient && faultSet)
+		{
+			if(job.Rtl ? saSim.FiResetRTL() : saSim.FiResetCsim())
+			{
+				sasError("FiReset failed\n");
+				shmSlot->Ret = -8;
+			}
+
+			faultSet = false;
+		}
+
+		// A failed job may leave jobs queued or a fault set on the warm instance
+		if(0 != shmSlot->Ret)
+		{
+			saSim.Reset(randomBits());
+			faultSet = false;
+		}
+
+		shmSlot->State.store(slotState::Done, std::memory_order_release);
+		if(sem_post(&shmSlot->DoneSem))
+		{
+			sasError("sem_post failed\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+SimServerClient::SimServerClient()
+{
+}
+
+SimServerClient::~SimServerClient()
+{
+	if(nullptr != Shm_)
+	{
+		munmap(Shm_, ShmSize_);
+	}
+}
+
+int SimServerClient::Open(const char * name, const SystolicArraySim &saSim)
+{
+	if(nullptr != Shm_)
+	{
+		sasError("Already open\n");
+		return -1;
+	}
+
+	const int fd = shm_open(name, O_RDWR, 0);
+	if(0 > fd)
+	{
+		sasError("shm_open %s failed, is the server running?\n", name);
+		return -2;
+	}
+
+	struct stat shmStat;
+	if(fstat(fd, &shmStat) || (sizeof(shmHeader_t) > (size_t) shmStat.st_size))
+	{
+		sasError("Invalid shared memory object %s\n", name);
+		close(fd);
+		return -2;
+	}
+
+	void * shm = mmap(NULL, shmStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(MAP_FAILED == shm)
+	{
+		sasError("mmap failed\n");
+		return -2;
+	}
+
+	const shmHeader_t * header = (const shmHeader_t *) shm;
+	const bool headerValid = (shmMagic == header->Magic) && (shmVersion == header->Version) &&
+			((size_t) shmStat.st_size >= roundUp(sizeof(shmHeader_t), shmPageSize) + header->SlotCnt * header->SlotSize);
+	if(!headerValid)
+	{
+		sasError("Shared memory object %s not created by a compatible server\n", name);
+		munmap(shm, shmStat.st_size);
+		return -3;
+	}
+
+	if((saSim.Mmma() != header->Mmma) || (saSim.Kmma() != header->Kmma) || (saSim.Nmma() != header->Nmma) ||
+			(saSim.Mtile() != header->Mtile) || (saSim.Ntile() != header->Ntile) ||
+			(maxOutM(saSim) > header->MaxM) || (maxOutN(saSim) > header->MaxN))
+	{
+		sasError("Server simulates a different Systolic Array geometry\n");
+		munmap(shm, shmStat.st_size);
+		return -4;
+	}
+
+	if(0 != strncmp(saSim.FiRegion(), header->FiRegion, sizeof(header->FiRegion)))
+	{
+		sasError("Server simulates FI region %.*s, not %s\n", (int) sizeof(header->FiRegion), header->FiRegion, saSim.FiRegion());
+		munmap(shm, shmStat.st_size);
+		return -4;
+	}
+
+	Shm_ = shm;
+	ShmSize_ = shmStat.st_size;
+
+	return 0;
+}
+
+bool SimServerClient::Fits(size_t M, size_t K, size_t N) const
+{
+	const shmHeader_t * header = (const shmHeader_t *) Shm_;
+	return (nullptr != header) && (M <= header->MaxM) && (K <= header->MaxK) && (N <= header->MaxN);
+}
+
+int SimServerClient::Acquire(ticket_t * ticket)
+{
+	shmHeader_t * header = (shmHeader_t *) Shm_;
+	if(nullptr == header)
+	{
+		sasError("Open first\n");
+		return -1;
+	}
+
+	// Reclaims the slots of dead clients while waiting
+	auto giveUp = [this, header]()
+	{
+		for(size_t slot = 0; slot < header->SlotCnt; slot++)
+		{
+			shmSlot_t * shmSlot = slotGet(Shm_, slot);
+			slotState state = shmSlot->State.load(std::memory_order_acquire);
+			if(((slotState::Claimed == state) || (slotState::Done == state)) && !processAlive(shmSlot->ClientPid) &&
+					shmSlot->State.compare_exchange_strong(state, slotState::Free, std::memory_order_acq_rel))
+			{
+				sasWarning("Reclaimed slot %lu of dead client %i\n", slot, (int) shmSlot->ClientPid);
+				shmSlot->ClientPid = 0;
+				sem_post(&header->FreeSem);
+			}
+		}
+
+		return header->Shutdown || !processAlive(header->ServerPid);
+	};
+
+	if(header->Shutdown)
+	{
+		sasError("Server shut down\n");
+		return -2;
+	}
+
+	if(const int waitRet = semWaitPoll(&header->FreeSem, giveUp))
+	{
+		sasError((-2 == waitRet) ? "Server shut down or gone\n" : "sem_wait failed\n");
+		return -2;
+	}
+
+	// The semaphore guarantees a free slot
+	while(true)
+	{
+		for(size_t slot = 0; slot < header->SlotCnt; slot++)
+		{
+			shmSlot_t * shmSlot = slotGet(Shm_, slot);
+			slotState expected = slotState::Free;
+			if(shmSlot->State.compare_exchange_strong(expected, slotState::Claimed, std::memory_order_acquire))
+			{
+				shmSlot->ClientPid = getpid();
+				ticket->Slot = slot;
+				ticket->MatA = slotMatA(header, shmSlot);
+				ticket->MatB = slotMatB(header, shmSlot);
+				ticket->MatC = slotMatC(header, shmSlot);
+				return 0;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int SimServerClient::Exec(const ticket_t &ticket, const SimServer::job_t &job, SimServer::fault_t * fault, bool * errorDetected)
+{
+	shmHeader_t * header = (shmHeader_t *) Shm_;
+	shmSlot_t * shmSlot = slotGet(Shm_, ticket.Slot);
+
+	if(!Fits(job.M, job.K, job.N))
+	{
+		sasError("Job doesn't fit into slot\n");
+		return -1;
+	}
+
+	if(header->Shutdown)
+	{
+		sasError("Server shut down\n");
+		return -2;
+	}
+
+	shmSlot->Job = job;
+	shmSlot->Fault = *fault;
+	shmSlot->State.store(slotState::Submitted, std::memory_order_release);
+
+	if(sem_post(&header->SubmitSem))
+	{
+		sasError("sem_post failed\n");
+		return -2;
+	}
+
+	// Gives up if the server is gone. At shutdown, a job not yet taken is withdrawn, a running one awaited
+	auto giveUp = [header, shmSlot]()
+	{
+		slotState expected = slotState::Submitted;
+		return !processAlive(header->ServerPid) || (header->Shutdown &&
+				shmSlot->State.compare_exchange_strong(expected, slotState::Claimed, std::memory_order_acq_rel));
+	};
+
+	if(const int waitRet = semWaitPoll(&shmSlot->DoneSem, giveUp))
+	{
+		sasError((-2 == waitRet) ? "Server shut down or gone\n" : "sem_wait failed\n");
+		return -2;
+	}
+
+	if(slotState::Done != shmSlot->State.load(std::memory_order_acquire))
+	{
+		sasError("Slot not done\n");
+		return -3;
+	}
+
+	*fault = shmSlot->Fault;
+	*errorDetected = shmSlot->ErrorDetected;
+
+	if(shmSlot->Ret)
+	{
+		sasError("Server failed job (%i)\n", shmSlot->Ret);
+		return -4;
+	}
+
+	return 0;
+}
+
+void SimServerClient::Release(const ticket_t &ticket)
+{
+	shmHeader_t * header = (shmHeader_t *) Shm_;
+
+	shmSlot_t * shmSlot = slotGet(Shm_, ticket.Slot);
+	shmSlot->ClientPid = 0;
+	shmSlot->State.store(slotState::Free, std::memory_order_release);
+	sem_post(&header->FreeSem);
+}
+
+int SimServer::UnitTest()
+{
+	const SystolicArraySim saSim;
+	const std::string nameStr = "/hdfit_simserver_test_" + std::to_string(getpid()); // shards may run side by side
+	const char * name = nameStr.c_str();
+	const size_t K = 3 * saSim.Kmma();
+
+	SimServer server;
+	if(server.Create(name, 2, K))
+	{
+		sasError("Create failed\n");
+		return -1;
+	}
+
+	std::thread serverThread([&server]() {server.Run(2);});
+
+	int ret = 0;
+	SimServerClient client;
+	if(client.Open(name, saSim))
+	{
+		sasError("Open failed\n");
+		ret = -2;
+	}
+
+	// Runs a job with random operands. Returns the count of elements differing from the fault free result
+	auto jobRun = [&saSim, &client, K](size_t test, bool tileEn, fault_t * fault, size_t * diffCnt)
+	{
+		const size_t M = tileEn ? saSim.Mtile() : 2 * saSim.Mmma();
+		const size_t N = tileEn ? saSim.Ntile() : 2 * saSim.Nmma();
+		const job_t job = {false, tileEn, 2, 2, M, K, N, saSim.Kmma(), test};
+
+		SimServerClient::ticket_t ticket;
+		if(client.Acquire(&ticket))
+		{
+			sasError("Test %lu: Acquire failed\n", test);
+			return -1;
+		}
+
+		for(size_t index = 0; index < M * K; index++)
+		{
+			ticket.MatA[index] = randomDouble(-5, 5, 0.1);
+		}
+
+		for(size_t index = 0; index < K * N; index++)
+		{
+			ticket.MatB[index] = randomDouble(-5, 5, 0.1);
+		}
+
+		std::vector<double> expected(M * N);
+		for(size_t row = 0; row < M; row++)
+		{
+			for(size_t col = 0; col < N; col++)
+			{
+				ticket.MatC[row * N + col] = randomDouble(-5, 5, 0.1);
+				expected[row * N + col] = ticket.MatC[row * N + col];
+				for(size_t sum = 0; sum < K; sum++)
+				{
+					expected[row * N + col] += ticket.MatA[row * K + sum] * ticket.MatB[sum * N + col];
+				}
+			}
+		}
+
+		bool errorDetected = false;
+		if(client.Exec(ticket, job, fault, &errorDetected))
+		{
+			sasError("Test %lu: Exec failed\n", test);
+			client.Release(ticket);
+			return -2;
+		}
+
+		*diffCnt = 0;
+		for(size_t index = 0; index < M * N; index++)
+		{
+			const double relDiff = fabs(ticket.MatC[index] - expected[index]) / std::max(fabs(expected[index]), 1.0);
+			if(!(0.000000001 >= relDiff))
+			{
+				(*diffCnt)++;
+			}
+		}
+
+		client.Release(ticket);
+		return 0;
+	};
+
+	// Tile and grouped MMA jobs, fault free
+	for(size_t test = 0; (0 == ret) && (test < 4); test++)
+	{
+		fault_t fault = {};
+		size_t diffCnt = 0;
+		if(jobRun(test, 0 == test % 2, &fault, &diffCnt))
+		{
+			ret = -3;
+		}
+		else if(0 != diffCnt)
+		{
+			sasError("Test %lu: %lu elements differ\n", test, diffCnt);
+			ret = -4;
+		}
+	}
+
+	// Permanent fault, kept by the worker for the second job. Chain entries beyond ChainLen differ,
+	// as they are ignored. The fault free job after must be correct again
+	for(size_t test = 4; (0 == ret) && (test < 7); test++)
+	{
+		fault_t fault = {};
+		if(6 > test)
+		{
+			fault.Mode = SystolicArraySim::fiMode::Permanent;
+			fault.Csim.Place = SystolicArraySim::fiCsimPlace::ColumnAdders;
+			fault.Csim.Corruption = SystolicArraySim::fiCorruption::Flip;
+			fault.Csim.Mode = SystolicArraySim::fiMode::Permanent;
+			fault.Csim.BitPos = 63;
+			fault.Chain[test] = test;
+		}
+
+		size_t diffCnt = 0;
+		if(jobRun(test, true, &fault, &diffCnt))
+		{
+			ret = -5;
+		}
+		else if((6 > test) == (0 == diffCnt))
+		{
+			sasError("Test %lu: %lu elements differ\n", test, diffCnt);
+			ret = -6;
+		}
+	}
+
+	// Transient fault, chosen by the worker and returned
+	for(size_t test = 7; (0 == ret) && (test < 9); test++)
+	{
+		fault_t fault = {};
+		if(7 == test)
+		{
+			fault.Mode = SystolicArraySim::fiMode::Transient;
+			fault.Bits = SystolicArraySim::fiBits::Everywhere;
+			fault.Csim.Place = SystolicArraySim::fiCsimPlace::Everywhere;
+			fault.Csim.Corruption = SystolicArraySim::fiCorruption::Flip;
+			fault.Cycle = SIZE_MAX;
+		}
+
+		size_t diffCnt = 0;
+		if(jobRun(test, false, &fault, &diffCnt))
+		{
+			ret = -7;
+		}
+		else if((7 == test) && ((SystolicArraySim::fiCsimPlace::None == fault.Csim.Place) ||
+				(SystolicArraySim::fiCsimPlace::Everywhere == fault.Csim.Place) || (SIZE_MAX == fault.Cycle)))
+		{
+			sasError("Test %lu: No transient fault returned\n", test);
+			ret = -8;
+		}
+		else if((8 == test) && (0 != diffCnt))
+		{
+			sasError("Test %lu: %lu elements differ\n", test, diffCnt);
+			ret = -9;
+		}
+	}
+
+	// The slot of a dead client is reclaimed
+	SimServerClient::ticket_t tickets[3];
+	if((0 == ret) && (client.Acquire(&tickets[0]) || client.Acquire(&tickets[1])))
+	{
+		sasError("Acquire failed\n");
+		ret = -12;
+	}
+
+	if(0 == ret)
+	{
+		const pid_t child = fork();
+		if(0 == child)
+		{
+			_exit(0);
+		}
+
+		waitpid(child, nullptr, 0);
+		slotGet(server.Shm_, tickets[0].Slot)->ClientPid = child;
+
+		if(client.Acquire(&tickets[2]) || (tickets[0].Slot != tickets[2].Slot))
+		{
+			sasError("Slot of dead client not reclaimed\n");
+			ret = -13;
+		}
+		else
+		{
+			client.Release(tickets[2]);
+		}
+
+		client.Release(tickets[1]);
+	}
+
+	// A ticket held across shutdown fails instead of waiting
+	SimServerClient::ticket_t ticket;
+	if((0 == ret) && client.Acquire(&ticket))
+	{
+		sasError("Acquire failed\n");
+		ret = -10;
+	}
+
+	server.Stop();
+	serverThread.join();
+
+	if(0 == ret)
+	{
+		fault_t fault = {};
+		bool errorDetected = false;
+		const job_t job = {false, true, 2, 2, saSim.Mtile(), K, saSim.Ntile(), saSim.Kmma(), 0};
+		if(0 == client.Exec(ticket, job, &fault, &errorDetected))
+		{
+			sasError("Exec after shutdown succeeded\n");
+			ret = -11;
+		}
+
+		client.Release(ticket);
+	}
+
+	return ret;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#ifndef SIMSERVER_H_
+#define SIMSERVER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "systolicArraySim.h"
+
+// Node-local simulation daemon: Clients (e.g. the BLAS hook of every MPI rank) pass output tile
+// jobs through a POSIX shared memory ring of slots. A client writes its operand panels directly
+// into a slot, one of the server's workers simulates it on a warm SystolicArraySim instance
+// and leaves the resulting C tile in the same slot.
+
+class SimServer {
+public:
+	SimServer();
+	virtual ~SimServer();
+
+	SimServer & operator=(const SimServer&) = delete;
+	SimServer(const SimServer &server) = delete;
+
+	static const char * const DefaultName; // shared memory object name
+	static const size_t MaxChainLen = 32; // max. ModuleInstanceChain length of an RTL fault
+
+	// Fault of a job. Permanent faults are set as given. For transient faults the worker
+	// chooses one (from Bits, Csim.Place and Csim.Corruption for Csim) and returns it here
+	typedef struct {
+		SystolicArraySim::fiMode Mode;
+		SystolicArraySim::fiBits Bits; // Csim transient faults only
+		SystolicArraySim::faultCsim_t Csim;
+		uint32_t AssignUUID;
+		uint16_t BitPos;
+		uint16_t ChainLen;
+		uint16_t Chain[MaxChainLen];
+		size_t Cycle; // transient faults: cycle chosen by the worker, e.g. for a later replay
+	} fault_t;
+
+	static int FaultFromRTL(fault_t * fault, const SystolicArraySim::faultRTL_t &faultRTL);
+	static SystolicArraySim::faultRTL_t FaultToRTL(const fault_t &fault);
+
+	// C (M x N) += A (M x K) * B (K x N), all row-major with stride = column count
+	typedef struct {
+		bool Rtl; // ExecRtl, else ExecCsim
+		bool TileEn; // DispatchTile, else DispatchMma
+		size_t MmaPositionsM; // for DispatchMma
+		size_t MmaPositionsN;
+		size_t M;
+		size_t K; // multiple of KCnt
+		size_t N;
+		size_t KCnt; // K of each dispatched job
+		uint64_t Seed; // of the worker's fault choices for this job, see SystolicArraySim::Seed
+	} job_t;
+
+	// Creates the shared memory ring, replacing a stale one of the same name.
+	// maxK: max. K of a job, bounds the slot size
+	// fiRegion: Netlist simulated for RTL faults (see SystolicArraySim::FiRegionSet), nullptr for the default
+	int Create(const char * name, size_t slotCnt, size_t maxK, const char * fiRegion = nullptr);
+
+	// Simulates submitted jobs on workerCnt threads until Stop is called
+	int Run(size_t workerCnt);
+
+	// Async-signal-safe
+	void Stop();
+
+	static int UnitTest(); // Runs a server in-process, assumes srand was called outside!
+
+private:
+	void * Shm_ = nullptr;
+	size_t ShmSize_ = 0;
+	char Name_[256] = {};
+	size_t WorkerCnt_ = 0;
+
+	int Worker();
+};
+
+class SimServerClient {
+public:
+	SimServerClient();
+	virtual ~SimServerClient();
+
+	SimServerClient & operator=(const SimServerClient&) = delete;
+	SimServerClient(const SimServerClient &client) = delete;
+
+	// Connects to a running server, whose geometry and FI region must match saSim's
+	int Open(const char * name, const SystolicArraySim &saSim);
+
+	bool Fits(size_t M, size_t K, size_t N) const; // does a job of this size fit into a slot?
+
+	// Operands are written directly into the slot, with row strides K (A), N (B) and N (C)
+	typedef struct {
+		size_t Slot;
+		double * MatA;
+		double * MatB;
+		double * MatC;
+	} ticket_t;
+
+	// Blocks until a slot is free
+	int Acquire(ticket_t * ticket);
+
+	// Blocks until the job was simulated, C is then in ticket.MatC
+	int Exec(const ticket_t &ticket, const SimServer::job_t &job, SimServer::fault_t * fault, bool * errorDetected);
+
+	void Release(const ticket_t &ticket);
+
+private:
+	void * Shm_ = nullptr;
+	size_t ShmSize_ = 0;
+};
+
+#endif /* SIMSERVER_H_ */
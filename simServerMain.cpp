@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License, as published
+ * by the Free Software Foundation; either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "helpers.h"
+
+#include "simServer.h"
+
+static SimServer * server = nullptr;
+
+static void stopHandler(int signal)
+{
+	server->Stop();
+}
+
+static void usage(const char * appName)
+{
+	sasInfo("Usage: %s [-n shm name] [-w workers] [-s slots] [-k max. K] [-d fault dictionary] [-f FI region] [-c FMA instances]\n", appName);
+	sasInfo("\tFMA instances: Comma separated, cone of influence simulation of the clients' RTL faults, see SystolicArraySim::CoiEnable\n");
+}
+
+int main(int argc, char ** argv)
+{
+	const char * name = SimServer::DefaultName;
+	size_t workerCnt = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+	size_t slotCnt = 0; // default: 2 per worker, so clients fill slots while workers simulate
+	size_t maxK = 4096;
+	const char * dictPath = nullptr; // for Fma faults of clients, see SystolicArraySim::DictEnable
+	const char * fiRegion = nullptr; // netlist of RTL faults, clients must select the same, see SystolicArraySim::FiRegionSet
+	std::vector<uint16_t> fmaInstances; // BLASFI_COI of clients doesn't apply to the server
+
+	int opt;
+	while(-1 != (opt = getopt(argc, argv, "n:w:s:k:d:f:c:h")))
+	{
+		switch(opt)
+		{
+		case 'n':
+			name = optarg;
+			break;
+
+		case 'w':
+			workerCnt = strtoul(optarg, NULL, 0);
+			break;
+
+		case 's':
+			slotCnt = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'k':
+			maxK = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'd':
+			dictPath = optarg;
+			break;
+
+		case 'f':
+			fiRegion = optarg;
+			break;
+
+		case 'c':
+			for(const char * pos = optarg; '\0' != *pos; pos += (',' == *pos) ? 1 : 0)
+			{
+				char * end;
+				fmaInstances.push_back(strtoul(pos, &end, 0));
+				if((end == pos) || ((',' != *end) && ('\0' != *end)))
+				{
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+
+				pos = end;
+			}
+			break;
+
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if(0 == slotCnt)
+	{
+		slotCnt = 2 * workerCnt;
+	}
+
+	srand(time(NULL));
+
+	if((nullptr != dictPath) && SystolicArraySim::DictEnable(dictPath))
+	{
+		sasFatal("DictEnable failed\n");
+	}
+
+	if(!fmaInstances.empty() && SystolicArraySim::CoiEnable(fmaInstances))
+	{
+		sasFatal("CoiEnable failed\n");
+	}
+
+	SimServer simServer;
+	if(simServer.Create(name, slotCnt, maxK, fiRegion))
+	{
+		sasFatal("Create failed\n");
+	}
+
+	server = &simServer;
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopHandler;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	sasInfo("Serving %s: %lu workers, %lu slots, K <= %lu, FI region %s, cone of influence %s\n", name, workerCnt, slotCnt, maxK,
+			(nullptr != fiRegion) ? fiRegion : "SystolicArray", fmaInstances.empty() ? "off" : "on");
+
+	if(simServer.Run(workerCnt))
+	{
+		sasFatal("Run failed\n");
+	}
+
+	sasInfo("Shut down\n");
+
+	return 0;
+}
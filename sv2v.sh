@@ -1,2 +1,5 @@
 #!/bin/sh
-for f in *.sv; do sv2v --write=./netlist/${f%.sv}.v -E=Always -E=Assert -E=Interface -E=Logic -E=UnbasedUnsized $f; done
+# $1: output directory (default netlist), further arguments are passed to sv2v, e.g. defines
+DIR=${1:-netlist}
+[ $# -gt 0 ] && shift
+for f in *.sv; do sv2v --write=./$DIR/${f%.sv}.v -E=Always -E=Assert -E=Interface -E=Logic -E=UnbasedUnsized "$@" $f; done
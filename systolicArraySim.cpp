@@ -22,27 +22,42 @@
 #include <float.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <array>
 #include <climits>
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <cmath>
+#include <type_traits>
 
 #include "verilated.h"
+#include "verilated_save.h"
 
 #ifdef NETLIST
 #include "netlistFaultInjector.hpp"
 #endif // NETLIST
 
+// NETLIST builds link both models: Fault free runs take the uninstrumented RTL model
 #ifdef NETLIST
 #include "VSystolicArray_netlist.h"
-#else // !NETLIST
+#include "VSystolicArray_fma.h" // FMA of the netlist, for the cone of influence simulation
+#include "VSystolicArray___024root.h"
+#ifdef FI_REGIONS
+#include "fiRegions.h" // models of FI_REGIONS and their FI_REGION_LIST, generated by the Makefile
+#endif // FI_REGIONS
+#endif // NETLIST
 #include "VSystolicArray.h"
-#endif // !NETLIST
 
 #include "helpers.h"
 
 #include "systolicArraySim.h"
+#include "faultSampler.h"
+#include "faultDictionary.h"
+#include "resultCompare.h"
 
 #ifdef VERILATED_VSYSTOLICARRAY_NETLIST_H_
 #define testBench_t VSystolicArray_netlist
@@ -50,8 +65,18 @@
 #define testBench_t VSystolicArray
 #endif // !VERILATED_VSYSTOLICARRAY_NETLIST_H_
 
+// FI regions linked besides the fully instrumented netlist, X(region) each
+#ifndef FI_REGION_LIST
+#define FI_REGION_LIST(X)
+#endif // FI_REGION_LIST
+
+// Index 0 is the fully instrumented netlist, then those of FI_REGION_LIST, see FiRegionSet
+#define FI_REGION_NAME(region) #region,
+static const char * const fiRegionNames[] = {"SystolicArray", FI_REGION_LIST(FI_REGION_NAME)};
+#undef FI_REGION_NAME
+
 static const double unitTestRelTolerance = 0.0000000003;
-static int unitTestExponentRange = INT_MAX; // TODO: Having this global is ugly
+static thread_local int unitTestExponentRange = INT_MAX; // of the running unit test case
 
 template <typename Enumeration>
 auto to_integer(Enumeration const value)
@@ -60,8 +85,272 @@ auto to_integer(Enumeration const value)
     return static_cast<typename std::underlying_type<Enumeration>::type>(value);
 }
 
+// Fault dictionary of fiCsimPlace::Fma faults, see DictEnable. Instances may use their own, see DictUse
+static std::shared_ptr<const FaultDictionary> faultDictionary;
+
+
+#ifdef NETLIST
+// Fault sites of the netlist are the same for all instances: Initialized once on first use.
+// Shared by all threads, and by forked processes through copy-on-write. Draw through netlistRandomFiGet only
+static NetlistFaultInjector * netlistFaultInjectorGet()
+{
+	static NetlistFaultInjector * netlistFaultInjector = []()
+	{
+		auto injector = new NetlistFaultInjector;
+		if(injector->Init()) // TODO: Would be nicer if it used the struct required as input
+		{
+			sasError("NetlistFaultInjector Init failed\n");
+		}
+
+		return injector;
+	}();
+
+	return netlistFaultInjector;
+}
+
+// Fault sites of the FI regions' netlists, each with an own injector (see fiRegion.cpp)
+#define FI_REGION_RANDOM_FI_GET(region) extern "C" int fiRegionRandomFiGet_##region(std::vector<uint16_t> * chain, uint32_t * assignNr, size_t * width);
+FI_REGION_LIST(FI_REGION_RANDOM_FI_GET)
+#undef FI_REGION_RANDOM_FI_GET
+
+// RandomFiGet draws from rand(): Seeded from prng first, so the site is given by the seed of prng
+// like all other fault choices. Instances draw concurrently from the shared injectors and rand() is
+// process wide, so draws hold randMutex as all users of rand()
+static int netlistRandomFiGet(size_t region, Prng &prng, std::vector<uint16_t> * chain, uint32_t * assignNr, size_t * width)
+{
+	std::lock_guard<std::mutex> lock(randMutex());
+	NetlistFaultInjector * netlistFaultInjector = netlistFaultInjectorGet();
+	srand(prng.Next() >> 32);
+
+	[[maybe_unused]] size_t index = 0;
+#define FI_REGION_RANDOM_FI_GET(name) if(++index == region) {return fiRegionRandomFiGet_##name(chain, assignNr, width);}
+	FI_REGION_LIST(FI_REGION_RANDOM_FI_GET)
+#undef FI_REGION_RANDOM_FI_GET
+
+	return netlistFaultInjector->RandomFiGet(chain, assignNr, width);
+}
+
+// Calls f with a null pointer of the type of the FI region's netlist model (VSystolicArray_netlist_<region>)
+template <typename function>
+static auto fiRegionNetlist(size_t region, function f)
+{
+	[[maybe_unused]] size_t index = 0;
+#define FI_REGION_NETLIST(name) if(++index == region) {return f((VSystolicArray_netlist_##name*) nullptr);}
+	FI_REGION_LIST(FI_REGION_NETLIST)
+#undef FI_REGION_NETLIST
+
+	return f((VSystolicArray_netlist*) nullptr);
+}
+
+// Calls f with a null pointer of the type of the FI region's FMA model (VSystolicArray_fma_<region>)
+template <typename function>
+static auto fiRegionFma(size_t region, function f)
+{
+	[[maybe_unused]] size_t index = 0;
+#define FI_REGION_FMA(name) if(++index == region) {return f((VSystolicArray_fma_##name*) nullptr);}
+	FI_REGION_LIST(FI_REGION_FMA)
+#undef FI_REGION_FMA
+
+	return f((VSystolicArray_fma*) nullptr);
+}
+
+// Cone of influence simulation: First ModuleInstanceChain entry of each FMA's sites, see CoiEnable
+static std::vector<uint16_t> coiFmaInstances;
+
+// Fault signals are the same in the row and the FMA netlist
+template <typename testBench>
+static void fiSignalsSet(testBench * Tb, const std::vector<uint16_t> &modInst, uint32_t assignNr, size_t fiBit)
+{
+	// Set instance chain
+	for(size_t inst = 0; inst < sizeof(Tb->GlobalFiModInstNr) / sizeof(Tb->GlobalFiModInstNr[0]); inst++)
+	{
+		if(modInst.size() > inst)
+		{
+			Tb->GlobalFiModInstNr[inst] = modInst[inst];
+		}
+		else
+		{
+			Tb->GlobalFiModInstNr[inst] = 0;
+		}
+	}
+
+	Tb->GlobalFiNumber = assignNr;
+
+	// Reset whatever was set before in fi signal
+	memset(Tb->GlobalFiSignal.m_storage, 0, sizeof(Tb->GlobalFiSignal.m_storage));
+
+	// Set specific bit
+	const size_t bitsInArrayElem = sizeof(Tb->GlobalFiSignal.m_storage[0]) * 8;
+	const size_t arrayIndex = fiBit / bitsInArrayElem;
+	const size_t arrayBit = fiBit % bitsInArrayElem;
+
+	Tb->GlobalFiSignal.m_storage[arrayIndex] = 1UL << arrayBit;
+}
+
+template <typename testBench>
+static void fiSignalsReset(testBench * Tb)
+{
+	for(size_t inst = 0; inst < sizeof(Tb->GlobalFiModInstNr) / sizeof(Tb->GlobalFiModInstNr[0]); inst++)
+	{
+		Tb->GlobalFiModInstNr[inst] = 0;
+	}
+}
+
+// Sites of the array's FMAs in the FMA model: Its top is the FMA, one level shallower than in the array,
+// so the chain starts below the FMA's instance (the first entry, see CoiEnable)
+static std::vector<uint16_t> fmaSiteChain(const std::vector<uint16_t> &chain)
+{
+	return std::vector<uint16_t>(chain.empty() ? chain.end() : chain.begin() + 1, chain.end());
+}
+#else // !NETLIST
+// Without the netlist, the RTL model runs in its place
+template <typename function>
+static auto fiRegionNetlist(size_t region, function f)
+{
+	return f((testBench_t*) nullptr);
+}
+#endif // !NETLIST
+
+// Model state in memory, written by the models' operator<< (verilator --savable)
+class snapshotSave : public VerilatedSerialize {
+public:
+	explicit snapshotSave(std::vector<uint8_t> * data) : Data_(data) {header();};
+	virtual ~snapshotSave() {trailer(); flush();};
+
+	virtual void flush() override
+	{
+		Data_->insert(Data_->end(), m_bufp, m_cp);
+		m_cp = m_bufp;
+	};
+
+private:
+	std::vector<uint8_t> * Data_;
+};
+
+// Reads a snapshot into a model with operator>>, Begin rewinds it for the next one
+class snapshotRestore : public VerilatedDeserialize {
+public:
+	void Begin(const std::vector<uint8_t> * data)
+	{
+		Data_ = data;
+		Pos_ = 0;
+		m_cp = m_bufp;
+		m_endp = m_bufp;
+		fill();
+		header();
+	};
+
+	void End() {trailer();};
+
+	// Moves the unread bytes to the start of the buffer, then appends the next ones of the snapshot
+	virtual void fill() override
+	{
+		const size_t unread = m_endp - m_cp;
+		memmove(m_bufp, m_cp, unread);
+
+		const size_t cnt = std::min(bufferSize() - unread, Data_->size() - Pos_);
+		memcpy(m_bufp + unread, Data_->data() + Pos_, cnt);
+
+		m_cp = m_bufp;
+		m_endp = m_bufp + unread + cnt;
+		Pos_ += cnt;
+	};
+
+private:
+	const std::vector<uint8_t> * Data_ = nullptr;
+	size_t Pos_ = 0;
+};
+
+// State of Tb, including its VerilatedContext
+template <typename testBench>
+static std::vector<uint8_t> modelSnapshot(testBench * Tb)
+{
+	std::vector<uint8_t> data;
+	{
+		snapshotSave save(&data);
+		save << *Tb;
+	}
+
+	return data;
+}
+
+// State of a newly constructed model, taken once per model type
+template <typename testBench>
+static const std::vector<uint8_t> &modelPowerOn()
+{
+	static const std::vector<uint8_t> snapshot = []()
+	{
+		VerilatedContext context;
+		testBench model(&context);
+		return modelSnapshot(&model);
+	}();
+
+	return snapshot;
+}
+
+// Restores Tb to the state of a newly constructed model. This also restores Tb's VerilatedContext,
+// so models must not share the context with those of other instances (see ModelNew)
+template <typename testBench>
+static void modelReset(testBench * Tb)
+{
+	static thread_local snapshotRestore restore;
+	restore.Begin(&modelPowerOn<testBench>());
+	restore >> *Tb;
+	restore.End();
+}
+
+// Models of an instance share its own VerilatedContext: Instances run on different threads, and
+// modelReset of one would otherwise write the default context of all
+template <typename testBench>
+testBench * SystolicArraySim::ModelNew()
+{
+	if(nullptr == ContextVoid_)
+	{
+		ContextVoid_ = (void *) new VerilatedContext;
+	}
+
+	return new testBench((VerilatedContext*) ContextVoid_);
+}
+
+int SystolicArraySim::FiRegionSet(const char * region)
+{
+	const size_t regionCnt = sizeof(fiRegionNames) / sizeof(fiRegionNames[0]);
+	const auto name = std::find_if(fiRegionNames, fiRegionNames + regionCnt,
+			[region](const char * regionName) {return 0 == strcmp(region, regionName);});
+	if(fiRegionNames + regionCnt == name)
+	{
+		sasError("FI region %s not linked\n", region);
+		return -1;
+	}
+
+	// Models and fault sites of the previous region don't apply
+	if((size_t) (name - fiRegionNames) != FiRegion_)
+	{
+		ModelsDelete();
+		FiRegion_ = name - fiRegionNames;
+
+		FaultRTL_ = faultRTL_t();
+		FaultRTLTransCycle_ = SIZE_MAX;
+	}
+
+	return 0;
+}
+
+const char * SystolicArraySim::FiRegion() const
+{
+	return fiRegionNames[FiRegion_];
+}
+
+std::vector<std::string> SystolicArraySim::FiRegions()
+{
+	return std::vector<std::string>(fiRegionNames, fiRegionNames + sizeof(fiRegionNames) / sizeof(fiRegionNames[0]));
+}
+
+SystolicArraySim::SystolicArraySim() : SystolicArraySim(randomBits())
+{
+}
 
-SystolicArraySim::SystolicArraySim()
+SystolicArraySim::SystolicArraySim(uint64_t seed) : Prng_(seed)
 {
 	// Call  commandArgs  first!
 #if 0
@@ -69,26 +358,42 @@ SystolicArraySim::SystolicArraySim()
 	Verilated::commandArgs(1, (const char **) &appName); // TODO: Find out what the args look like
 #endif
 
-	//  Instantiate our design
-	TbVoid_ = (void *) new testBench_t;
+	// Design is instantiated by the first ExecRtl, fault sites by the first FiSetRTL:
+	// Instances only used for configuration or Csim don't pay for either
+}
 
-#ifdef NETLIST
-	// Initialize NetlistFaultInjector
-	auto netlistFaultInjector = new NetlistFaultInjector;
-	if(netlistFaultInjector->Init()) // TODO: Would be nicer if it used the struct required as input
+SystolicArraySim::~SystolicArraySim() {
+	ModelsDelete();
+	delete (VSystolicArray*) TbFastVoid_;
+	delete (VerilatedContext*) ContextVoid_;
+}
+
+void SystolicArraySim::ModelsDelete()
+{
+	fiRegionNetlist(FiRegion_, [this](auto * netlist)
 	{
-		sasError("NetlistFaultInjector Init failed\n");
-	}
+		typedef std::remove_pointer_t<decltype(netlist)> netlist_t;
 
-	NetlistFaultInjectorVoid_ = (void*) netlistFaultInjector;
-#endif // NETLIST
-}
+		delete (netlist_t*) TbVoid_;
 
-SystolicArraySim::~SystolicArraySim() {
-	delete (testBench_t*) TbVoid_;
+		for(void * tbVoid : BatchTbVoid_)
+		{
+			delete (netlist_t*) tbVoid;
+		}
+	});
+
+	TbVoid_ = nullptr;
+	BatchTbVoid_.clear();
 
 #ifdef NETLIST
-	delete (NetlistFaultInjector *) NetlistFaultInjectorVoid_;
+	fiRegionFma(FiRegion_, [this](auto * fma)
+	{
+		for(void * &tbVoid : TbFmaVoid_)
+		{
+			delete (std::remove_pointer_t<decltype(fma)>*) tbVoid;
+			tbVoid = nullptr;
+		}
+	});
 #endif // NETLIST
 }
 
@@ -97,11 +402,11 @@ int SystolicArraySim::DispatchMma(const job_t &job)
 #if DEBUG_VERBOSE
 	sasDebug("Dispatched Job:\n");
 	sasDebug("A =\n");
-	matrixPrint(job.MatA, Config_.Mmma, Config_.Kmma, job.StrideA);
+	matrixPrint(job.MatA, Config_.Mmma, Config_.Kmma, job.StrideA, job.ColStrideA);
 	sasDebug("B =\n");
-	matrixPrint(job.MatB, Config_.Kmma, Config_.Nmma, job.StrideB);
+	matrixPrint(job.MatB, Config_.Kmma, Config_.Nmma, job.StrideB, job.ColStrideB);
 	sasDebug("C =\n");
-	matrixPrint(job.MatC, Config_.Mmma, Config_.Nmma, job.StrideC);
+	matrixPrint(job.MatC, Config_.Mmma, Config_.Nmma, job.StrideC, job.ColStrideC);
 #endif // DEBUG_VERBOSE
 
 	JobQueue_.push_back({0, job});
@@ -114,26 +419,27 @@ int SystolicArraySim::DispatchMma(const job_t &job, size_t mCnt, size_t nCnt)
 #if DEBUG_VERBOSE
 	sasDebug("Dispatched %lu x %lu MMAs:\n", mCnt, nCnt);
 	sasDebug("A =\n");
-	matrixPrint(job.MatA, mCnt * Mmma(), Ktile(), job.StrideA);
+	matrixPrint(job.MatA, mCnt * Mmma(), Ktile(), job.StrideA, job.ColStrideA);
 	sasDebug("B =\n");
-	matrixPrint(job.MatB, Ktile(), nCnt * Nmma(), job.StrideB);
+	matrixPrint(job.MatB, Ktile(), nCnt * Nmma(), job.StrideB, job.ColStrideB);
 	sasDebug("C =\n");
-	matrixPrint(job.MatC, mCnt * Mmma(), nCnt * Nmma(), job.StrideC);
+	matrixPrint(job.MatC, mCnt * Mmma(), nCnt * Nmma(), job.StrideC, job.ColStrideC);
 #endif // DEBUG_VERBOSE
 
 	// Left buffer larger than right buffer: Walk through rows first
 	for(size_t row = 0; row < mCnt * Mmma(); row += Mmma())
 	{
-		const double * Ap = job.MatA + row * job.StrideA;
+		const double * Ap = &job.ElemA(row, 0);
 		for(size_t col = 0; col < nCnt * Nmma(); col += Nmma())
 		{
-			const double * Bp = job.MatB + col;
-			double * Cp = job.MatC + row * job.StrideC + col;
+			const double * Bp = &job.ElemB(0, col);
+			double * Cp = &job.ElemC(row, col);
 
 			const job_t jobMma = {
 					Ap, job.StrideA,
 					Bp, job.StrideB,
-					Cp, job.StrideC};
+					Cp, job.StrideC,
+					job.ColStrideA, job.ColStrideB, job.ColStrideC};
 
 			if(DispatchMma(jobMma))
 			{
@@ -151,26 +457,27 @@ int SystolicArraySim::DispatchTile(const job_t &job)
 #if DEBUG_VERBOSE
 	sasDebug("Dispatched Tile:\n");
 	sasDebug("A =\n");
-	matrixPrint(job.MatA, Mtile(), Ktile(), job.StrideA);
+	matrixPrint(job.MatA, Mtile(), Ktile(), job.StrideA, job.ColStrideA);
 	sasDebug("B =\n");
-	matrixPrint(job.MatB, Ktile(), Ntile(), job.StrideB);
+	matrixPrint(job.MatB, Ktile(), Ntile(), job.StrideB, job.ColStrideB);
 	sasDebug("C =\n");
-	matrixPrint(job.MatC, Mtile(), Ntile(), job.StrideC);
+	matrixPrint(job.MatC, Mtile(), Ntile(), job.StrideC, job.ColStrideC);
 #endif // DEBUG_VERBOSE
 
 	// Left buffer larger than right buffer: Walk through rows first
 	for(size_t row = 0; row < Mtile(); row += Mmma())
 	{
-		const double * Ap = job.MatA + row * job.StrideA;
+		const double * Ap = &job.ElemA(row, 0);
 		for(size_t col = 0; col < Ntile(); col += Nmma())
 		{
-			const double * Bp = job.MatB + col;
-			double * Cp = job.MatC + row * job.StrideC + col;
+			const double * Bp = &job.ElemB(0, col);
+			double * Cp = &job.ElemC(row, col);
 
 			const job_t jobMma = {
 					Ap, job.StrideA,
 					Bp, job.StrideB,
-					Cp, job.StrideC};
+					Cp, job.StrideC,
+					job.ColStrideA, job.ColStrideB, job.ColStrideC};
 
 			if(DispatchMma(jobMma))
 			{
@@ -315,6 +622,144 @@ int SystolicArraySim::DispatchTile(const job_t &job)
 	return toDouble(tmp);
 }
 
+// Ports of the RTL model: Unpacked arrays of 65'b values. Only sizes are read, Tb may be nullptr
+[[maybe_unused]] static size_t mmmaRtlGet(const VSystolicArray * Tb)
+{
+	return sizeof(Tb->out) / sizeof(Tb->out[0]);
+}
+
+[[maybe_unused]] static size_t kmmaRtlGet(const VSystolicArray * Tb)
+{
+	return sizeof(Tb->multRight) / sizeof(Tb->multRight[0]);
+}
+
+[[maybe_unused]] static int leftSet(VSystolicArray * Tb, size_t index, double value)
+{
+	return setValue(Tb->multLeft[0], index, value);
+}
+
+[[maybe_unused]] static int rightSet(VSystolicArray * Tb, size_t k, double value)
+{
+	return setValue(Tb->multRight, k, value);
+}
+
+[[maybe_unused]] static int accSet(VSystolicArray * Tb, size_t m, double value)
+{
+	return setValue(Tb->acc, m, value);
+}
+
+[[maybe_unused]] static double outGet(VSystolicArray * Tb, size_t m)
+{
+	return getValue(Tb->out, m);
+}
+
+#ifdef NETLIST
+// Ports of the netlists (of all FI regions): 65'b values packed into one wide signal
+template <typename netlist>
+[[maybe_unused]] static size_t mmmaRtlGet(const netlist * Tb)
+{
+	return (sizeof(Tb->out.m_storage) * 8) / 65;
+}
+
+template <typename netlist>
+[[maybe_unused]] static size_t kmmaRtlGet(const netlist * Tb)
+{
+	return (sizeof(Tb->multRight.m_storage) * 8) / 65;
+}
+
+template <typename netlist>
+[[maybe_unused]] static int leftSet(netlist * Tb, size_t index, double value)
+{
+	return setValue(Tb->multLeft.data(), sizeof(Tb->multLeft.m_storage), 65, index, value);
+}
+
+template <typename netlist>
+[[maybe_unused]] static int rightSet(netlist * Tb, size_t k, double value)
+{
+	return setValue(Tb->multRight.data(), sizeof(Tb->multRight.m_storage), 65, k, value);
+}
+
+template <typename netlist>
+[[maybe_unused]] static int accSet(netlist * Tb, size_t m, double value)
+{
+	return setValue(Tb->acc.data(), sizeof(Tb->acc.m_storage), 65, m, value);
+}
+
+template <typename netlist>
+[[maybe_unused]] static double outGet(netlist * Tb, size_t m)
+{
+	return getValue(Tb->out.data(), sizeof(Tb->out.m_storage), 65, m);
+}
+#endif // NETLIST
+
+SystolicArraySim::config_t SystolicArraySim::ConfigGet()
+{
+	const config_t config = {
+			8, kmmaRtlGet((const testBench_t*) nullptr), 8, // Mmma, Kmma, Nmma
+			8, 2, // BufferLeftSize, BufferRightSize
+			8 * 4, 4 * 8, // Mtile, Ntile
+			4, 16}; // ThreadCnt, SystolicArrayCnt
+
+	return config;
+}
+
+size_t SystolicArraySim::MmmaRtl()
+{
+	return mmmaRtlGet((const testBench_t*) nullptr);
+}
+
+void SystolicArraySim::Reset(uint64_t seed)
+{
+	Prng_.Seed(seed);
+	JobQueue_.clear();
+	CycleCnt_ = 0;
+	DieError_ = false;
+	FastModelEn_ = true;
+
+	FaultCsim_ = faultCsim_t();
+	FaultCsimTransCycle_ = SIZE_MAX;
+	FaultDictPattern_ = {};
+
+	FaultRTL_.ModuleInstanceChain.clear();
+	FaultRTL_.AssignUUID = 0;
+	FaultRTL_.BitPos = UINT16_MAX;
+	FaultRTL_.Mode = fiMode::None;
+	FaultRTLTransCycle_ = SIZE_MAX;
+
+	fiRegionNetlist(FiRegion_, [this](auto * netlist)
+	{
+		typedef std::remove_pointer_t<decltype(netlist)> netlist_t;
+
+		if(nullptr != TbVoid_)
+		{
+			modelReset((netlist_t*) TbVoid_);
+		}
+
+		for(void * tbVoid : BatchTbVoid_)
+		{
+			modelReset((netlist_t*) tbVoid);
+		}
+	});
+
+#ifdef NETLIST
+	if(nullptr != TbFastVoid_)
+	{
+		modelReset((VSystolicArray*) TbFastVoid_);
+	}
+
+	fiRegionFma(FiRegion_, [this](auto * fma)
+	{
+		for(void * tbVoid : TbFmaVoid_)
+		{
+			if(nullptr != tbVoid)
+			{
+				modelReset((std::remove_pointer_t<decltype(fma)>*) tbVoid);
+			}
+		}
+	});
+#endif // NETLIST
+}
+
 size_t SystolicArraySim::CyclesRequired(size_t jobCnt) const
 {
 	if(0 == jobCnt)
@@ -335,7 +780,8 @@ size_t SystolicArraySim::JobsDoneInCycles(size_t cycleCnt) const
 	return (cycleCnt - JobCycleDone_ - 1) / (JobCyclePassedFirstStage_ + 1) + 1;
 }
 
-int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool clkHigh)
+template <typename testBench>
+int SystolicArraySim::IoSet(testBench * Tb, std::deque<queueEntry_t> * jobs, bool clkHigh, const testBench * operandTb)
 {
 	if(jobs->empty())
 	{
@@ -356,13 +802,7 @@ int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool
 		}
 	}
 
-	testBench_t * Tb = (testBench_t*) TbVoid;
-
-#ifdef NETLIST
-	const size_t MmmaRTL = (sizeof(Tb->out.m_storage) * 8) / 65;
-#else // !NETLIST
-	const size_t MmmaRTL = (sizeof(Tb->out->m_storage) * 8) / 65;
-#endif // !NETLIST
+	const size_t MmmaRTL = mmmaRtlGet(Tb);
 
 	for(size_t job = 0; job < concurrentJobs.size(); job++)
 	{
@@ -389,16 +829,12 @@ int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool
 			// To add some complications, each SA row is separated into two independent phase-shifted FMAs
 			const bool lInEvenK = (0 == concurrentJobs[job]->JobCycle % FmaCycles_);
 			const bool lInOddK = (0 == (concurrentJobs[job]->JobCycle - 1) % FmaCycles_) && concurrentJobs[job]->JobCycle;
-			if(lInEvenK || lInOddK)
+			if((nullptr == operandTb) && (lInEvenK || lInOddK))
 			{
 				const size_t k = 2 * (concurrentJobs[job]->JobCycle / FmaCycles_) + (lInEvenK ? 0 : 1);
 				if(k < Kmma())
 				{
-#ifdef NETLIST
-					if(setValue(Tb->multLeft.data(), sizeof(Tb->multLeft.m_storage), 65, m * Kmma() + k, jobp->MatA[m * jobp->StrideA + k]))
-#else // !NETLIST
-					if(setValue(Tb->multLeft[0], m * Kmma() + k, jobp->MatA[m * jobp->StrideA + k]))
-#endif // !NETLIST
+					if(leftSet(Tb, m * Kmma() + k, jobp->ElemA(m, k)))
 					{
 						sasError("setValue failed\n");
 						return -1;
@@ -407,7 +843,7 @@ int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool
 			}
 
 			// Right matrix input
-			const size_t nCnt = std::min(concurrentJobs[job]->JobCycle / 2 + 1, Nmma());
+			const size_t nCnt = (nullptr == operandTb) ? std::min(concurrentJobs[job]->JobCycle / 2 + 1, Nmma()) : 0;
 			for(size_t n = 0; n < nCnt; n++)
 			{
 				const size_t nJobCycle = concurrentJobs[job]->JobCycle - 2 * n;
@@ -418,11 +854,7 @@ int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool
 					const size_t k = 2 * (nJobCycle / FmaCycles_) + (rInEvenK ? 0: 1);
 					if(k < Kmma())
 					{
-#ifdef NETLIST
-						if(setValue(Tb->multRight.data(), sizeof(Tb->multRight.m_storage), 65, k, jobp->MatB[k * jobp->StrideB + n]))
-#else // !NETLIST
-						if(setValue(Tb->multRight, k, jobp->MatB[k * jobp->StrideB + n]))
-#endif // !NETLIST
+						if(rightSet(Tb, k, jobp->ElemB(k, n)))
 						{
 							sasError("setValue failed\n");
 							return -1;
@@ -437,11 +869,7 @@ int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool
 				const size_t n = concurrentJobs[job]->JobCycle / 2;
 				if(n < Nmma())
 				{
-#ifdef NETLIST
-					if(setValue(Tb->acc.data(), sizeof(Tb->acc.m_storage), 65, m, jobp->MatC[m * jobp->StrideC + n]))
-#else // !NETLIST
-					if(setValue(Tb->acc, m, jobp->MatC[m * jobp->StrideC + n]))
-#endif // !NETLIST
+					if(accSet(Tb, m, jobp->ElemC(m, n)))
 					{
 						sasError("setValue failed\n");
 						return -1;
@@ -461,16 +889,19 @@ int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool
 						sasError("Unexpected n: Job should have been removed already\n");
 						return -1;
 					}
-#ifdef NETLIST
-					jobp->MatC[m * jobp->StrideC + n] = getValue(Tb->out.data(), sizeof(Tb->out.m_storage), 65, m);
-#else // !NETLIST
-					jobp->MatC[m * jobp->StrideC + n] = getValue(Tb->out, m);
-#endif // !NETLIST
+					jobp->ElemC(m, n) = outGet(Tb, m);
 				}
 			}
 		}
 	}
 
+	// Operand inputs only depend on A, B and the job cycles, i.e. are the same for all jobs queues of a batch
+	if(nullptr != operandTb)
+	{
+		memcpy(&Tb->multLeft, &operandTb->multLeft, sizeof(Tb->multLeft));
+		memcpy(&Tb->multRight, &operandTb->multRight, sizeof(Tb->multRight));
+	}
+
 	if(JobCycleDone_ == jobs->front().JobCycle)
 	{
 		// Are we only simulating a single column of the SA?
@@ -484,7 +915,7 @@ int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool
 				{
 					for(size_t k = 0; k < Kmma(); k++)
 					{
-						jobp->MatC[row * jobp->StrideC + col] += jobp->MatA[row * jobp->StrideA + k] * jobp->MatB[k * jobp->StrideB + col];
+						jobp->ElemC(row, col) += jobp->ElemA(row, k) * jobp->ElemB(k, col);
 					}
 				}
 			}
@@ -506,7 +937,7 @@ int SystolicArraySim::IoSet(void * TbVoid, std::deque<queueEntry_t> * jobs, bool
 	return 0;
 }
 
-SystolicArraySim::faultRTL_t SystolicArraySim::FiSetRTL(fiMode mode)
+SystolicArraySim::faultRTL_t SystolicArraySim::FiSetRTL(fiMode mode, FaultSampler * sampler, std::string * stratum)
 {
 #ifdef NETLIST
 	if(fiMode::None == mode)
@@ -515,19 +946,51 @@ SystolicArraySim::faultRTL_t SystolicArraySim::FiSetRTL(fiMode mode)
 		return faultRTL_t();
 	}
 
-	NetlistFaultInjector * netlistFaultInjector = (NetlistFaultInjector*) NetlistFaultInjectorVoid_;
 	size_t fiSignalWidth = 0;
 
-	if(netlistFaultInjector->RandomFiGet(
-			&FaultRTL_.ModuleInstanceChain,
-			&FaultRTL_.AssignUUID,
-			&fiSignalWidth))
+	// Sites are drawn uniformly over assigns: With a sampler, until one is in its target stratum
+	const std::string target = (nullptr != sampler) ? sampler->Target() : std::string();
+	std::string candidate;
+	for(size_t draw = 0; draw < FaultSampler::MaxDraws; draw++)
+	{
+		if(netlistRandomFiGet(
+				FiRegion_,
+				Prng_,
+				&FaultRTL_.ModuleInstanceChain,
+				&FaultRTL_.AssignUUID,
+				&fiSignalWidth))
+		{
+			sasError("RandomFiGet failed\n");
+			return faultRTL_t();
+		}
+
+		if(nullptr == sampler)
+		{
+			break;
+		}
+
+		candidate = sampler->Stratum(FaultRTL_.ModuleInstanceChain, fiSignalWidth);
+		sampler->Candidate(candidate, fiSignalWidth);
+
+		if(nullptr != stratum)
+		{
+			*stratum = candidate;
+		}
+
+		if(target.empty() || (target == candidate))
+		{
+			break;
+		}
+	}
+
+	// The fault is recorded in the stratum it was drawn from, i.e. estimates stay unbiased, but the target isn't served
+	if(!target.empty() && (target != candidate))
 	{
-		sasError("RandomFiGet failed\n");
-		return faultRTL_t();
+		sasWarning("Target stratum %s not drawn in %lu candidates, injecting into %s\n",
+				target.c_str(), FaultSampler::MaxDraws, candidate.c_str());
 	}
 
-	FaultRTL_.BitPos = randomBits() % fiSignalWidth;
+	FaultRTL_.BitPos = Prng_.Below(fiSignalWidth);
 
 	if(fiMode::Transient == mode)
 	{
@@ -539,7 +1002,7 @@ SystolicArraySim::faultRTL_t SystolicArraySim::FiSetRTL(fiMode mode)
 			return faultRTL_t();
 		}
 
-		FaultRTLTransCycle_ = randomBits() % cyclesRequired;
+		FaultRTLTransCycle_ = Prng_.Below(cyclesRequired);
 	}
 
 	FaultRTL_.Mode = mode;
@@ -573,15 +1036,19 @@ SystolicArraySim::faultCsim_t SystolicArraySim::FiSetCsim(
 		return faultCsim_t();
 	}
 
+	if(fiCsimPlace::Fma == place)
+	{
+		return FiSetCsimFma(mode);
+	}
+
 	if(fiCsimPlace::Everywhere == place)
 	{
 		// Assuming equal distribution across
 		// inputs, Kmma multipliers, Kmma acc adders, 1 final column adder)
 		// I.e. 2 * Kmma + 1 components (inputs have significant derating)
 		// TODO: Multiplier much larger than adder
-		// coverity[DC.WEAK_CRYPTO]
-		const int randNr = rand();
-		const int FractionRandMax = RAND_MAX / (2 * Kmma() + 1);
+		const int randNr = Prng_.Next() >> 33; // 0 ... INT32_MAX
+		const int FractionRandMax = INT32_MAX / (2 * Kmma() + 1);
 		if(randNr < Kmma() * FractionRandMax)
 		{
 			FaultCsim_.Place = fiCsimPlace::Multipliers;
@@ -610,8 +1077,7 @@ SystolicArraySim::faultCsim_t SystolicArraySim::FiSetCsim(
 	{
 		CycleCnt_ = 0;
 		const size_t totalJobQueueCycles = JobQueue_.size() * Nmma();
-		// coverity[DC.WEAK_CRYPTO]
-		FaultCsimTransCycle_ = rand() % totalJobQueueCycles;
+		FaultCsimTransCycle_ = Prng_.Below(totalJobQueueCycles);
 	}
 
 	FaultCsim_.Mode = mode;
@@ -624,29 +1090,241 @@ SystolicArraySim::faultCsim_t SystolicArraySim::FiSetCsim(
 		return faultCsim_t();
 
 	case fiBits::Everywhere:
-		// coverity[DC.WEAK_CRYPTO]
-		FaultCsim_.BitPos = rand() % (sizeof(double) * 8);
+		FaultCsim_.BitPos = Prng_.Below(sizeof(double) * 8);
 		break;
 
 	case fiBits::Mantissa:
-		// coverity[DC.WEAK_CRYPTO]
-		FaultCsim_.BitPos = rand() % 52;
+		FaultCsim_.BitPos = Prng_.Below(52);
 		break;
 	}
 
-	// coverity[DC.WEAK_CRYPTO]
-	FaultCsim_.Row = rand() % Mmma();
+	FaultCsim_.Row = Prng_.Below(Mmma());
+
+	// Drawn here rather than during execution, so the fault as returned replays exactly
+	FaultCsim_.Fma = Prng_.Below(Kmma());
+	FaultCsim_.Input = Prng_.Below(3);
 
-	sasFaultPrint("Set FaultCsim_: Place %i, Corruption %i, fiMode %i, Column %u, BitPos %u\n",
+	sasFaultPrint("Set FaultCsim_: Place %i, Corruption %i, fiMode %i, Column %u, BitPos %u, Fma %u, Input %u\n",
 			to_integer(FaultCsim_.Place), to_integer(FaultCsim_.Corruption),
-			to_integer(FaultCsim_.Mode), FaultCsim_.Row, FaultCsim_.BitPos);
+			to_integer(FaultCsim_.Mode), FaultCsim_.Row, FaultCsim_.BitPos, FaultCsim_.Fma, FaultCsim_.Input);
 
 	return FaultCsim_;
 }
 
-int SystolicArraySim::FiResetRTL()
+int SystolicArraySim::FiSetRTL(const faultRTL_t &fault)
 {
-	if(fiMode::None == FaultRTL_.Mode)
+#ifdef NETLIST
+	if(fiMode::Permanent != fault.Mode)
+	{
+		sasError("Only permanent faults can be set directly\n");
+		return -1;
+	}
+
+	if(UINT16_MAX == fault.BitPos)
+	{
+		sasError("Invalid fault\n");
+		return -2;
+	}
+
+	FaultRTL_ = fault;
+
+	sasFaultPrint("Set FaultRTL_ (copy): AssignUUID = %u, BitPos = %u\n",
+			FaultRTL_.AssignUUID, FaultRTL_.BitPos);
+
+	return 0;
+
+#else // !NETLIST
+	sasError("Only available with NETLIST\n");
+	return -1;
+#endif // !NETLIST
+}
+
+int SystolicArraySim::FiSetRTL(const faultRTL_t &fault, size_t cycle)
+{
+#ifdef NETLIST
+	if(fiMode::Transient != fault.Mode)
+	{
+		sasError("Only transient faults can be set for a cycle\n");
+		return -1;
+	}
+
+	if(UINT16_MAX == fault.BitPos)
+	{
+		sasError("Invalid fault\n");
+		return -2;
+	}
+
+	const size_t cyclesRequired = CyclesRequired(JobQueue_.size());
+	if(cyclesRequired <= cycle)
+	{
+		sasError("Cycle %lu outside of job queue (%lu cycles)\n", cycle, cyclesRequired);
+		return -3;
+	}
+
+	CycleCnt_ = 0;
+	FaultRTL_ = fault;
+	FaultRTLTransCycle_ = cycle;
+
+	sasFaultPrint("Set FaultRTL_ (replay): AssignUUID = %u, BitPos = %u, Cycle = %lu\n",
+			FaultRTL_.AssignUUID, FaultRTL_.BitPos, FaultRTLTransCycle_);
+
+	return 0;
+
+#else // !NETLIST
+	sasError("Only available with NETLIST\n");
+	return -1;
+#endif // !NETLIST
+}
+
+int SystolicArraySim::FiSetCsim(const faultCsim_t &fault)
+{
+	if(fiMode::Permanent != fault.Mode)
+	{
+		sasError("Only permanent faults can be set directly\n");
+		return -1;
+	}
+
+	if((fiCsimPlace::None == fault.Place) || (fiCsimPlace::Everywhere == fault.Place) ||
+			(fiCsimPlace::Fma == fault.Place) || (fiCorruption::None == fault.Corruption) ||
+			(sizeof(double) * 8 <= fault.BitPos) || (Mmma() <= fault.Row) || (Kmma() <= fault.Fma) || (3 <= fault.Input))
+	{
+		sasError("Invalid fault\n");
+		return -2;
+	}
+
+	FaultCsim_ = fault;
+
+	sasFaultPrint("Set FaultCsim_ (copy): Place %i, Corruption %i, Column %u, BitPos %u\n",
+			to_integer(FaultCsim_.Place), to_integer(FaultCsim_.Corruption),
+			FaultCsim_.Row, FaultCsim_.BitPos);
+
+	return 0;
+}
+
+int SystolicArraySim::FiSetCsim(const faultCsim_t &fault, size_t cycle)
+{
+	if(fiMode::Transient != fault.Mode)
+	{
+		sasError("Only transient faults can be set for a cycle\n");
+		return -1;
+	}
+
+	if((fiCsimPlace::Fma == fault.Place) ? !FiCsimFmaValid(fault) :
+			((fiCsimPlace::None == fault.Place) || (fiCsimPlace::Everywhere == fault.Place) ||
+			(fiCorruption::None == fault.Corruption) ||
+			(sizeof(double) * 8 <= fault.BitPos) || (Mmma() <= fault.Row) || (Kmma() <= fault.Fma) || (3 <= fault.Input)))
+	{
+		sasError("Invalid fault\n");
+		return -2;
+	}
+
+	const size_t totalJobQueueCycles = (fiCsimPlace::Fma == fault.Place) ? CyclesRequired(JobQueue_.size()) : JobQueue_.size() * Nmma();
+	if(totalJobQueueCycles <= cycle)
+	{
+		sasError("Cycle %lu outside of job queue (%lu cycles)\n", cycle, totalJobQueueCycles);
+		return -3;
+	}
+
+	if(fiCsimPlace::Fma == fault.Place)
+	{
+		// Operations of FMA k enter in odd cycles for odd k (see ExecDict)
+		const FaultDictionary::pattern_t * pattern = Dict()->Pattern(fault.Site, fault.SiteBit, (cycle + fault.Fma) % 2, fault.SitePattern);
+		if(nullptr == pattern)
+		{
+			sasError("Site %u, bit %u has no pattern %u in this phase\n", fault.Site, fault.SiteBit, fault.SitePattern);
+			return -4;
+		}
+
+		FaultDictPattern_ = *pattern;
+	}
+
+	CycleCnt_ = 0;
+	FaultCsim_ = fault;
+	FaultCsimTransCycle_ = cycle;
+
+	sasFaultPrint("Set FaultCsim_ (replay): Place %i, Corruption %i, Column %u, BitPos %u, Cycle %lu\n",
+			to_integer(FaultCsim_.Place), to_integer(FaultCsim_.Corruption),
+			FaultCsim_.Row, FaultCsim_.BitPos, FaultCsimTransCycle_);
+
+	if(fiCsimPlace::Fma == FaultCsim_.Place)
+	{
+		sasFaultPrint("\tFMA %u, Site %u, SiteBit %u, SitePattern %u\n", FaultCsim_.Fma, FaultCsim_.Site, FaultCsim_.SiteBit,
+				FaultCsim_.SitePattern);
+	}
+
+	return 0;
+}
+
+bool SystolicArraySim::FiCsimFmaValid(const faultCsim_t &fault) const
+{
+	if(nullptr == Dict())
+	{
+		sasError("No fault dictionary, see DictEnable\n");
+		return false;
+	}
+
+	return (fiMode::Transient == fault.Mode) && (Mmma() > fault.Row) && (Kmma() > fault.Fma) &&
+			Dict()->Characterized(fault.Site, fault.SiteBit);
+}
+
+SystolicArraySim::faultCsim_t SystolicArraySim::FiSetCsimFma(fiMode mode)
+{
+	if(nullptr == Dict())
+	{
+		sasError("No fault dictionary, see DictEnable\n");
+		return faultCsim_t();
+	}
+
+	if(fiMode::Transient != mode)
+	{
+		sasError("Only transient FMA faults are characterized\n");
+		return faultCsim_t();
+	}
+
+	const size_t cyclesRequired = CyclesRequired(JobQueue_.size());
+	if(0 == cyclesRequired)
+	{
+		sasError("Trying to set transient fault with empty JobQueue\n");
+		return faultCsim_t();
+	}
+
+	size_t site;
+	faultCsim_t fault;
+	if(Dict()->SiteDraw(&Prng_, &site, &fault.SiteBit))
+	{
+		sasError("SiteDraw failed\n");
+		return faultCsim_t();
+	}
+
+	fault.Place = fiCsimPlace::Fma;
+	fault.Corruption = fiCorruption::Flip;
+	fault.Mode = mode;
+	fault.Row = Prng_.Below(Mmma());
+	fault.Fma = Prng_.Below(Kmma());
+	fault.Site = site;
+
+	// The pattern is part of the fault, so FiSetCsim replays it
+	const size_t cycle = Prng_.Below(cyclesRequired);
+	size_t pattern;
+	if(nullptr == Dict()->PatternDraw(&Prng_, site, fault.SiteBit, (cycle + fault.Fma) % 2, &pattern))
+	{
+		sasError("Site %lu, bit %u not characterized in this phase\n", site, fault.SiteBit);
+		return faultCsim_t();
+	}
+	fault.SitePattern = pattern;
+
+	if(FiSetCsim(fault, cycle))
+	{
+		sasError("FiSetCsim failed\n");
+		return faultCsim_t();
+	}
+
+	return FaultCsim_;
+}
+
+int SystolicArraySim::FiResetRTL()
+{
+	if(fiMode::None == FaultRTL_.Mode)
 	{
 		sasError("No fault was set!\n");
 		return -1;
@@ -706,26 +1384,21 @@ static double corrupt(double in, SystolicArraySim::fiCorruption corruption, uint
 }
 
 // out = out + A_1 * B_1 + ... + A_8 * B_8
-// fi = nullptr if no fault injection intended
+// fi = nullptr if no fault injection intended, else it hits FMA fi->Fma
 int SystolicArraySim::RowCsim(double * out, double * a, double * b, const faultCsim_t * fi) const
 {
-	// coverity[DC.WEAK_CRYPTO]
-	int kFi = rand() % Kmma();
-
 	for(size_t k = 0; k < Kmma(); k++)
 	{
-		if((k == kFi) && (nullptr != fi))
+		if((nullptr != fi) && (k == fi->Fma))
 		{
 			// Inputs
 			double accIn = *out;
 			double aIn = a[k];
 			double bIn = b[k];
-			if(fiCsimPlace::Multipliers == fi->Place)
+			if((fiCsimPlace::Multipliers == fi->Place) || (fiCsimPlace::Inputs == fi->Place))
 			{
-				// coverity[DC.WEAK_CRYPTO]
-				size_t inRand = rand() % 3;
-				if(0 == inRand) accIn = corrupt(*out, fi->Corruption, fi->BitPos);
-				else if(1 == inRand) aIn = corrupt(aIn, fi->Corruption, fi->BitPos);
+				if(0 == fi->Input) accIn = corrupt(*out, fi->Corruption, fi->BitPos);
+				else if(1 == fi->Input) aIn = corrupt(aIn, fi->Corruption, fi->BitPos);
 				else bIn = corrupt(bIn, fi->Corruption, fi->BitPos);
 			}
 
@@ -742,6 +1415,8 @@ int SystolicArraySim::RowCsim(double * out, double * a, double * b, const faultC
 			{
 				acc = corrupt(acc, fi->Corruption, fi->BitPos);
 			}
+
+			*out = acc;
 		}
 		else
 		{
@@ -759,6 +1434,11 @@ int SystolicArraySim::RowCsim(double * out, double * a, double * b, const faultC
 
 int SystolicArraySim::ExecCsim(size_t maxJobs)
 {
+	if(fiCsimPlace::Fma == FaultCsim_.Place)
+	{
+		return ExecDict(maxJobs);
+	}
+
 	const size_t origJobs = JobQueue_.size();
 	while(!JobQueue_.empty() && (origJobs - JobQueue_.size() < maxJobs))
 	{
@@ -776,7 +1456,7 @@ int SystolicArraySim::ExecCsim(size_t maxJobs)
 
 			for(size_t sum = 0; sum < Kmma(); sum++)
 			{
-				job->MatC[row * job->StrideC + col] += job->MatA[row * job->StrideA + sum] * job->MatB[sum * job->StrideB + col];
+				job->ElemC(row, col) += job->ElemA(row, sum) * job->ElemB(sum, col);
 			}
 		}
 
@@ -785,12 +1465,12 @@ int SystolicArraySim::ExecCsim(size_t maxJobs)
 		std::vector<double> rightIn(Kmma());
 		for(size_t sum = 0; sum < Kmma(); sum++)
 		{
-			leftIn[sum] = job->MatA[FaultCsim_.Row * job->StrideA + sum];
-			rightIn[sum] = job->MatB[sum * job->StrideB + col];
+			leftIn[sum] = job->ElemA(FaultCsim_.Row, sum);
+			rightIn[sum] = job->ElemB(sum, col);
 		}
 
 		const faultCsim_t * colCsimFi = ((CycleCnt_ == FaultCsimTransCycle_) || (fiMode::Permanent == FaultCsim_.Mode)) ? &FaultCsim_ : nullptr;
-		if(RowCsim(&job->MatC[FaultCsim_.Row * job->StrideC + col], leftIn.data(), rightIn.data(), colCsimFi))
+		if(RowCsim(&job->ElemC(FaultCsim_.Row, col), leftIn.data(), rightIn.data(), colCsimFi))
 		{
 			sasError("ColCsim failed\n");
 			return -1;
@@ -807,36 +1487,102 @@ int SystolicArraySim::ExecCsim(size_t maxJobs)
 	return 0;
 }
 
-int SystolicArraySim::FiRtlApply(void * TbVoid, const std::vector<uint16_t> &modInst, uint32_t assignNr, size_t fiBit)
+// XORs mask to the 65'b value of in, as output by an FMA
+static double dictCorrupt(double in, const uint32_t * mask)
 {
-#ifdef NETLIST
-	testBench_t * Tb = (testBench_t*) TbVoid;
+	sNFp64_t value;
+	if(elemSet(&value, in))
+	{
+		sasError("elemSet failed\n");
+		return NAN;
+	}
 
-	// Set instance chain
-	for(size_t inst = 0; inst < sizeof(Tb->GlobalFiModInstNr) / sizeof(Tb->GlobalFiModInstNr[0]); inst++)
+	for(size_t word = 0; word < FaultDictionary::Words; word++)
 	{
-		if(modInst.size() > inst)
+		value.m_storage[word] ^= mask[word];
+	}
+
+	const double out = toDouble(value);
+	sasFaultPrint("Corrupting %f -> %f\n", in, out);
+
+	return out;
+}
+
+// C model of an Fma fault: The operations of the faulty FMA in flight at the fault get the pattern's
+// masks. The rows' columns with one of them take the two accumulation chains of the RTL (see SystolicArray.sv)
+int SystolicArraySim::ExecDict(size_t maxJobs)
+{
+	// Operations of FMA k enter FmaCycles_ * (k / 2) + k % 2 + 2 * n cycles after their job started (see IoSet),
+	// and jobs start every JobCyclePassedFirstStage_ + 1 cycles
+	const size_t fma = FaultCsim_.Fma;
+	const int64_t entryOffset = FmaCycles_ * (fma / 2) + fma % 2;
+	const int64_t phase = (FaultCsimTransCycle_ + fma) % 2;
+
+	const size_t origJobs = JobQueue_.size();
+	while(!JobQueue_.empty() && (origJobs - JobQueue_.size() < maxJobs))
+	{
+		// JobCycle = col for c sim, and CycleCnt_ counts columns
+		job_t * job = &JobQueue_.front().Job;
+		const size_t col = JobQueue_.front().JobCycle;
+		const int64_t jobStart = (CycleCnt_ / Nmma()) * (JobCyclePassedFirstStage_ + 1);
+
+		// Entered 2 * stage + phase cycles before the fault
+		const int64_t entryDistance = (int64_t) FaultCsimTransCycle_ - phase - jobStart - entryOffset - 2 * (int64_t) col;
+		const uint32_t * mask = ((0 <= entryDistance) && ((int64_t) FaultDictionary::Stages > entryDistance / 2)) ?
+				&FaultDictPattern_[(entryDistance / 2) * FaultDictionary::Words] : nullptr;
+		const bool corrupted = (nullptr != mask) && std::any_of(mask, mask + FaultDictionary::Words, [](uint32_t word){return 0 != word;});
+
+		for(size_t row = 0; row < Mmma(); row++)
 		{
-			Tb->GlobalFiModInstNr[inst] = modInst[inst];
+			if(!corrupted || (FaultCsim_.Row != row))
+			{
+				for(size_t sum = 0; sum < Kmma(); sum++)
+				{
+					job->ElemC(row, col) += job->ElemA(row, sum) * job->ElemB(sum, col);
+				}
+
+				continue;
+			}
+
+			// Even FMAs accumulate C, odd ones start from 0
+			double chains[2] = {job->ElemC(row, col), 0};
+			for(size_t sum = 0; sum < Kmma(); sum++)
+			{
+				chains[sum % 2] += job->ElemA(row, sum) * job->ElemB(sum, col);
+				if(fma == sum)
+				{
+					chains[sum % 2] = dictCorrupt(chains[sum % 2], mask);
+				}
+			}
+
+			job->ElemC(row, col) = chains[0] + chains[1];
 		}
-		else
+
+		CycleCnt_++;
+		JobQueue_.front().JobCycle++;
+		if(JobQueue_.front().JobCycle >= Nmma())
 		{
-			Tb->GlobalFiModInstNr[inst] = 0;
+			JobQueue_.pop_front();
 		}
 	}
 
-	Tb->GlobalFiNumber = assignNr;
-
-	// Reset whatever was set before in fi signal
-	memset(Tb->GlobalFiSignal.m_storage, 0, sizeof(Tb->GlobalFiSignal.m_storage));
-
-	// Set specific bit
-	const size_t bitsInArrayElem = sizeof(Tb->GlobalFiSignal.m_storage[0]) * 8;
-	const size_t arrayIndex = fiBit / bitsInArrayElem;
-	const size_t arrayBit = fiBit % bitsInArrayElem;
-
-	Tb->GlobalFiSignal.m_storage[arrayIndex] = 1UL << arrayBit;
+	return 0;
+}
 
+template <typename testBench>
+int SystolicArraySim::FiRtlApply(testBench * Tb, const std::vector<uint16_t> &modInst, uint32_t assignNr, size_t fiBit)
+{
+#ifdef NETLIST
+	// Fault signals only exist in the netlists
+	if constexpr (std::is_same<testBench, VSystolicArray>::value)
+	{
+		sasError("RTL model has no fault signals\n");
+		return -1;
+	}
+	else
+	{
+		fiSignalsSet(Tb, modInst, assignNr, fiBit);
+	}
 #else // !NETLIST
 	sasError("Only available with NETLIST\n");
 	return -1;
@@ -845,81 +1591,462 @@ int SystolicArraySim::FiRtlApply(void * TbVoid, const std::vector<uint16_t> &mod
 	return 0;
 }
 
-int SystolicArraySim::FiRtlReset(void * TbVoid)
+template <typename testBench>
+int SystolicArraySim::FiRtlReset(testBench * Tb)
 {
 #ifdef NETLIST
-	testBench_t * Tb = (testBench_t*) TbVoid;
-
-	for(size_t inst = 0; inst < sizeof(Tb->GlobalFiModInstNr) / sizeof(Tb->GlobalFiModInstNr[0]); inst++)
+	if constexpr (!std::is_same<testBench, VSystolicArray>::value)
 	{
-		Tb->GlobalFiModInstNr[inst] = 0;
+		fiSignalsReset(Tb);
 	}
+#endif // NETLIST
 
 	return 0;
-
-#else // !NETLIST
-	return 0;
-#endif // !NETLIST
 }
 
-bool SystolicArraySim::JobQueueReadBeforeWrite(const std::deque<queueEntry_t> &jobQueue) const
+int SystolicArraySim::CoiEnable(const std::vector<uint16_t> &fmaInstances)
 {
-	const size_t jobsInPipe = JobCycleDone_ / JobCyclePassedFirstStage_;
-
-	for(size_t job = 0; job < jobQueue.size(); job++)
+	SystolicArraySim sysArraySim;
+	if(!fmaInstances.empty() && (fmaInstances.size() != sysArraySim.Kmma()))
 	{
-		for(size_t nextJob = job + 1; nextJob < std::min(job + jobsInPipe, jobQueue.size()); nextJob++)
-		{
-			if((jobQueue[job].Job.MatC == jobQueue[nextJob].Job.MatA) ||
-					(jobQueue[job].Job.MatC == jobQueue[nextJob].Job.MatB) ||
-					jobQueue[job].Job.MatC == jobQueue[nextJob].Job.MatC)
-			{
-				return true;
-			}
-		}
+		sasError("Expected %lu FMA instances, got %lu\n", sysArraySim.Kmma(), fmaInstances.size());
+		return -1;
 	}
 
-	return false;
+#ifdef NETLIST
+	coiFmaInstances = fmaInstances;
+	return 0;
+#else // !NETLIST
+	sasError("Only available with NETLIST\n");
+	return -1;
+#endif // !NETLIST
 }
 
-int SystolicArraySim::ExecRtl(bool fastTransient, bool fastTransientTest)
+const FaultDictionary * SystolicArraySim::Dict() const
 {
-	// Run sanity check on jobqueue
-	if(JobQueueReadBeforeWrite(JobQueue_))
-	{
-		sasError("Read before write in jobqueue\n");
-		return -1;
-	}
+	return (nullptr != Dict_) ? Dict_.get() : faultDictionary.get();
+}
 
-	// Set permanent fault if enabled
-	if(fiMode::Permanent == FaultRTL_.Mode)
+int SystolicArraySim::DictEnable(const char * path)
+{
+	if(nullptr == path)
 	{
-		if(FiRtlApply(TbVoid_, FaultRTL_.ModuleInstanceChain, FaultRTL_.AssignUUID, FaultRTL_.BitPos))
-		{
-			sasError("FiRtlApply failed\n");
-			return -1;
-		}
+		faultDictionary.reset();
+		return 0;
 	}
-	else if(FiRtlReset(TbVoid_))
+
+	std::unique_ptr<FaultDictionary> dict(new FaultDictionary);
+	if(dict->Load(path))
 	{
-		sasError("FiRtlReset failed\n");
+		sasError("Loading %s failed\n", path);
 		return -1;
 	}
 
-	// Skip jobs before transient fault happens
-	if((fiMode::Transient == FaultRTL_.Mode) && fastTransient)
+	faultDictionary = std::move(dict);
+	return 0;
+}
+
+#ifdef NETLIST
+// Operations enter the FMA every second cycle as in the array, and their output is read latency cycles
+// later (see the pipeline test of main.cpp). The fault occurs in faultCycle, stage s of the pattern is the
+// operation which entered 2 * s (+ 1) cycles before, i.e. ops.size() - 1 - s
+static int dictPatternGet(VSystolicArray_fma * faulty, VSystolicArray_fma * golden, const std::vector<std::array<double, 3>> &ops,
+		size_t latency, size_t faultCycle, const std::vector<uint16_t> &modInst, uint32_t assignNr, size_t fiBit,
+		FaultDictionary::pattern_t * pattern)
+{
+	pattern->fill(0);
+
+	// Without operations of the previous pattern in flight
+	modelReset(faulty);
+	modelReset(golden);
+	fiSignalsReset(golden);
+
+	for(size_t cycle = 0; cycle <= 2 * (ops.size() - 1) + latency; cycle++)
 	{
-		const size_t jobsBefore = FaultRTLTransCycle_ > JobCycleDone_ ? JobsDoneInCycles(FaultRTLTransCycle_ - JobCycleDone_) : 0;
-		if(jobsBefore)
+		for(VSystolicArray_fma * Tb : {faulty, golden})
 		{
-			if(ExecCsim(jobsBefore))
+			if((0 == cycle % 2) && (ops.size() > cycle / 2))
 			{
-				sasError("ExecCsim failed\n");
-				return -1;
+				const auto &op = ops[cycle / 2];
+				if(elemSet(&Tb->mult1, op[0]) || elemSet(&Tb->mult2, op[1]) || elemSet(&Tb->acc, op[2]))
+				{
+					sasError("elemSet failed\n");
+					return -1;
+				}
 			}
 
-			// reset cycle cnt
-			for(auto &job: JobQueue_)
+			Tb->clk = cycle % 2;
+		}
+
+		if(faultCycle == cycle)
+		{
+			fiSignalsSet(faulty, modInst, assignNr, fiBit);
+		}
+		else
+		{
+			fiSignalsReset(faulty);
+		}
+
+		faulty->eval();
+		golden->eval();
+
+		if((latency <= cycle) && (0 == (cycle - latency) % 2))
+		{
+			const size_t stage = ops.size() - 1 - (cycle - latency) / 2;
+			for(size_t word = 0; word < FaultDictionary::Words; word++)
+			{
+				(*pattern)[stage * FaultDictionary::Words + word] = faulty->out.m_storage[word] ^ golden->out.m_storage[word];
+			}
+		}
+	}
+
+	return 0;
+}
+#endif // NETLIST
+
+int SystolicArraySim::DictCharacterize(FaultDictionary * dict, const std::vector<uint16_t> &fmaInstances,
+		size_t siteCnt, size_t operandSets, int expRange)
+{
+#ifdef NETLIST
+	SystolicArraySim sysArraySim;
+	if(FaultDictionary::Stages != sysArraySim.FmaCycles_ / 2)
+	{
+		sasError("Dictionary expects %lu FMA stages, have %lu\n", FaultDictionary::Stages, sysArraySim.FmaCycles_ / 2);
+		return -1;
+	}
+
+	std::unique_ptr<VSystolicArray_fma> faulty(sysArraySim.ModelNew<VSystolicArray_fma>());
+	std::unique_ptr<VSystolicArray_fma> golden(sysArraySim.ModelNew<VSystolicArray_fma>());
+
+	const size_t latency = sysArraySim.FmaCycles_ - 2;
+	std::vector<std::array<double, 3>> ops(FaultDictionary::Stages);
+
+	for(size_t siteNr = 0; siteNr < siteCnt; siteNr++)
+	{
+		// Sites are drawn uniformly over assigns until one is inside an FMA
+		std::vector<uint16_t> chain;
+		uint32_t assignNr = 0;
+		size_t width = 0;
+		bool fmaSite = false;
+		for(size_t draw = 0; !fmaSite && (draw < FaultSampler::MaxDraws); draw++)
+		{
+			if(netlistRandomFiGet(sysArraySim.FiRegion_, sysArraySim.Prng_, &chain, &assignNr, &width))
+			{
+				sasError("RandomFiGet failed\n");
+				return -2;
+			}
+
+			fmaSite = !chain.empty() && (fmaInstances.end() != std::find(fmaInstances.begin(), fmaInstances.end(), chain[0]));
+		}
+
+		if(!fmaSite)
+		{
+			sasError("No FMA site drawn, check fmaInstances\n");
+			return -3;
+		}
+
+		// Recorded and injected below the FMA, as the FMA model's top is the FMA
+		const std::vector<uint16_t> fmaChain = fmaSiteChain(chain);
+		const size_t site = dict->SiteAdd(fmaChain, assignNr, width);
+		if(!dict->Site(site).Bits.empty())
+		{
+			continue;
+		}
+
+		sasInfo("Site %lu/%lu: AssignUUID %u, width %lu\n", siteNr + 1, siteCnt, assignNr, width);
+
+		for(size_t bit = 0; bit < width; bit++)
+		{
+			for(size_t phase = 0; phase < 2; phase++)
+			{
+				for(size_t set = 0; set < operandSets; set++)
+				{
+					for(auto &op : ops)
+					{
+						op = {randomDouble(-expRange, expRange, 0.1), randomDouble(-expRange, expRange, 0.1),
+								randomDouble(-expRange, expRange, 0.1)};
+					}
+
+					FaultDictionary::pattern_t pattern;
+					if(dictPatternGet(faulty.get(), golden.get(), ops, latency, 2 * (ops.size() - 1) + phase,
+							fmaChain, assignNr, bit, &pattern))
+					{
+						sasError("dictPatternGet failed\n");
+						return -4;
+					}
+
+					dict->Record(site, bit, phase, pattern);
+				}
+			}
+		}
+	}
+
+	return 0;
+#else // !NETLIST
+	sasError("Only available with NETLIST\n");
+	return -1;
+#endif // !NETLIST
+}
+
+template <typename testBench>
+void SystolicArraySim::FmaInputGet(const testBench * Tb, size_t fma, fmaInput_t * input)
+{
+	// Only the RTL model's FMA inputs are recorded, acc of an FMA is the output of the one two columns left
+#ifdef NETLIST
+	if constexpr (std::is_same<testBench, VSystolicArray>::value)
+	{
+		static_assert(sizeof(input->Mult1) == sizeof(Tb->acc[0]), "Unexpected 65'b value size");
+
+		memcpy(input->Mult1, Tb->multLeft[0][fma].data(), sizeof(input->Mult1));
+		memcpy(input->Mult2, Tb->multRight[fma].data(), sizeof(input->Mult2));
+
+		if(0 == fma)
+		{
+			memcpy(input->Acc, Tb->acc[0].data(), sizeof(input->Acc));
+		}
+		else if(1 == fma)
+		{
+			memset(input->Acc, 0, sizeof(input->Acc));
+		}
+		else
+		{
+			memcpy(input->Acc, Tb->rootp->SystolicArray__DOT__fma_m__BRA__0__KET____DOT__fmaAccOut[fma - 2].data(), sizeof(input->Acc));
+		}
+	}
+#endif // NETLIST
+}
+
+int SystolicArraySim::ExecCoi(size_t fma, bool fastTransient)
+{
+#ifdef NETLIST
+	// Fault free run on the fast model, recording the inputs of the faulty FMA. Its result stands if the
+	// FMA's output isn't affected by the fault, else everything is restored for the netlist
+	std::vector<std::pair<double *, double>> matCOrig;
+	for(const auto &entry : JobQueue_)
+	{
+		for(size_t row = 0; row < Mmma(); row++)
+		{
+			for(size_t col = 0; col < Nmma(); col++)
+			{
+				matCOrig.emplace_back(&entry.Job.ElemC(row, col), entry.Job.ElemC(row, col));
+			}
+		}
+	}
+
+	const std::deque<queueEntry_t> jobQueueOrig = JobQueue_;
+	const size_t cycleCntOrig = CycleCnt_;
+	const bool dieErrorOrig = DieError_;
+
+	if(nullptr == TbFastVoid_)
+	{
+		TbFastVoid_ = (void *) ModelNew<VSystolicArray>();
+	}
+
+	std::vector<fmaInput_t> inputs;
+	FmaInputs_ = &inputs;
+	FmaInputsIndex_ = fma;
+	const int fastRet = ExecRtlTb((VSystolicArray*) TbFastVoid_, fastTransient, true);
+	FmaInputs_ = nullptr;
+
+	if(fastRet)
+	{
+		sasError("ExecRtlTb failed\n");
+		return -1;
+	}
+
+	const bool masked = fiRegionFma(FiRegion_, [&](auto * fmaType) {return CoiMasked(fmaType, inputs, fma);});
+	if(masked)
+	{
+		sasDebug("Fault masked inside FMA %lu\n", fma);
+		return 0;
+	}
+
+	// Restore in reverse, so C of accumulating jobs ends up with its value before the first job
+	for(auto elem = matCOrig.rbegin(); elem != matCOrig.rend(); elem++)
+	{
+		*elem->first = elem->second;
+	}
+
+	JobQueue_ = jobQueueOrig;
+	CycleCnt_ = cycleCntOrig;
+	DieError_ = dieErrorOrig;
+
+	return ExecNetlist(fastTransient, false);
+#else // !NETLIST
+	sasError("Only available with NETLIST\n");
+	return -1;
+#endif // !NETLIST
+}
+
+#ifdef NETLIST
+// Replays the recorded inputs on the faulty and a fault free FMA of the FI region's netlist (fmaModel)
+template <typename fmaModel>
+bool SystolicArraySim::CoiMasked(const fmaModel * type, const std::vector<fmaInput_t> &inputs, size_t fma)
+{
+	for(auto &tbVoid : TbFmaVoid_)
+	{
+		if(nullptr == tbVoid)
+		{
+			tbVoid = (void *) ModelNew<fmaModel>();
+		}
+	}
+
+	// Both from reset: The replay of a previous fault may have stopped with operations in flight
+	fmaModel * fmaFaulty = (fmaModel*) TbFmaVoid_[0];
+	fmaModel * fmaGolden = (fmaModel*) TbFmaVoid_[1];
+	modelReset(fmaFaulty);
+	modelReset(fmaGolden);
+	fiSignalsReset(fmaGolden);
+
+	const std::vector<uint16_t> chain = fmaSiteChain(FaultRTL_.ModuleInstanceChain);
+
+	bool masked = true;
+	for(const auto &input : inputs)
+	{
+		for(fmaModel * Tb : {fmaFaulty, fmaGolden})
+		{
+			Tb->clk = (fma % 2) ? !input.Clk : input.Clk; // as fmaClock
+			memcpy(Tb->mult1.data(), input.Mult1, sizeof(input.Mult1));
+			memcpy(Tb->mult2.data(), input.Mult2, sizeof(input.Mult2));
+			memcpy(Tb->acc.data(), input.Acc, sizeof(input.Acc));
+		}
+
+		if(input.Cycle == FaultRTLTransCycle_)
+		{
+			fiSignalsSet(fmaFaulty, chain, FaultRTL_.AssignUUID, FaultRTL_.BitPos);
+		}
+		else
+		{
+			fiSignalsReset(fmaFaulty);
+		}
+
+		fmaFaulty->eval();
+		fmaGolden->eval();
+
+		if(memcmp(fmaFaulty->out.data(), fmaGolden->out.data(), sizeof(fmaFaulty->out.m_storage)))
+		{
+			masked = false;
+			break;
+		}
+	}
+
+	return masked;
+}
+#endif // NETLIST
+
+bool SystolicArraySim::JobQueueReadBeforeWrite(const std::deque<queueEntry_t> &jobQueue) const
+{
+	const size_t jobsInPipe = JobCycleDone_ / JobCyclePassedFirstStage_;
+
+	for(size_t job = 0; job < jobQueue.size(); job++)
+	{
+		for(size_t nextJob = job + 1; nextJob < std::min(job + jobsInPipe, jobQueue.size()); nextJob++)
+		{
+			if((jobQueue[job].Job.MatC == jobQueue[nextJob].Job.MatA) ||
+					(jobQueue[job].Job.MatC == jobQueue[nextJob].Job.MatB) ||
+					jobQueue[job].Job.MatC == jobQueue[nextJob].Job.MatC)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+int SystolicArraySim::ExecRtl(bool fastTransient, bool fastTransientTest)
+{
+	// Run sanity check on jobqueue
+	if(JobQueueReadBeforeWrite(JobQueue_))
+	{
+		sasError("Read before write in jobqueue\n");
+		return -1;
+	}
+
+#ifdef NETLIST
+	// Only an active fault needs the instrumented netlist
+	const bool faultEn = (fiMode::Permanent == FaultRTL_.Mode) ||
+			((fiMode::Transient == FaultRTL_.Mode) && !fastTransientTest);
+	// Transient fault inside an FMA
+	if(FastModelEn_ && (fiMode::Transient == FaultRTL_.Mode) && !fastTransientTest && !FaultRTL_.ModuleInstanceChain.empty())
+	{
+		const auto fma = std::find(coiFmaInstances.begin(), coiFmaInstances.end(), FaultRTL_.ModuleInstanceChain[0]);
+		if(coiFmaInstances.end() != fma)
+		{
+			return ExecCoi(fma - coiFmaInstances.begin(), fastTransient);
+		}
+	}
+
+	if(FastModelEn_ && !faultEn)
+	{
+		if(nullptr == TbFastVoid_)
+		{
+			TbFastVoid_ = (void *) ModelNew<VSystolicArray>();
+		}
+
+		return ExecRtlTb((VSystolicArray*) TbFastVoid_, fastTransient, fastTransientTest);
+	}
+#endif // NETLIST
+
+	return ExecNetlist(fastTransient, fastTransientTest);
+}
+
+int SystolicArraySim::ExecNetlist(bool fastTransient, bool fastTransientTest)
+{
+	return fiRegionNetlist(FiRegion_, [&](auto * netlist)
+	{
+		typedef std::remove_pointer_t<decltype(netlist)> netlist_t;
+
+		//  Instantiate our design
+		if(nullptr == TbVoid_)
+		{
+			TbVoid_ = (void *) ModelNew<netlist_t>();
+		}
+
+		return ExecRtlTb((netlist_t*) TbVoid_, fastTransient, fastTransientTest);
+	});
+}
+
+template <typename testBench>
+int SystolicArraySim::ExecRtlTb(testBench * Tb, bool fastTransient, bool fastTransientTest)
+{
+	// Fault signals only exist in the netlists: NETLIST builds run the RTL model fault free only
+	const bool fiSignalsEn = !std::is_same<testBench, VSystolicArray>::value;
+	if(!fiSignalsEn && ((fiMode::Permanent == FaultRTL_.Mode) || ((fiMode::Transient == FaultRTL_.Mode) && !fastTransientTest)))
+	{
+		sasError("RTL model has no fault signals, faults need the netlist\n");
+		return -1;
+	}
+
+	// Set permanent fault if enabled
+	if(fiMode::Permanent == FaultRTL_.Mode)
+	{
+		if(FiRtlApply(Tb, FaultRTL_.ModuleInstanceChain, FaultRTL_.AssignUUID, FaultRTL_.BitPos))
+		{
+			sasError("FiRtlApply failed\n");
+			return -1;
+		}
+	}
+	else if(fiSignalsEn && FiRtlReset(Tb))
+	{
+		sasError("FiRtlReset failed\n");
+		return -1;
+	}
+
+	// Skip jobs before transient fault happens
+	if((fiMode::Transient == FaultRTL_.Mode) && fastTransient)
+	{
+		const size_t jobsBefore = FaultRTLTransCycle_ > JobCycleDone_ ? JobsDoneInCycles(FaultRTLTransCycle_ - JobCycleDone_) : 0;
+		if(jobsBefore)
+		{
+			if(ExecCsim(jobsBefore))
+			{
+				sasError("ExecCsim failed\n");
+				return -1;
+			}
+
+			// reset cycle cnt
+			for(auto &job: JobQueue_)
 			{
 				job.JobCycle = 0;
 			}
@@ -932,13 +2059,13 @@ int SystolicArraySim::ExecRtl(bool fastTransient, bool fastTransientTest)
 	}
 
 	// Start the actual simulation
-	testBench_t * Tb = (testBench_t*) TbVoid_;
+	const size_t MmmaRTL = mmmaRtlGet(Tb);
 
-#ifdef NETLIST
-	const size_t MmmaRTL = (sizeof(Tb->out.m_storage) * 8) / 65;
-#else // !NETLIST
-	const size_t MmmaRTL = (sizeof(Tb->out->m_storage) * 8) / 65;
-#endif // !NETLIST
+	if(MmmaRTL > Mmma())
+	{
+		sasError("Model has %lu rows, more than %lu\n", MmmaRTL, Mmma());
+		return -1;
+	}
 
 	if(MmmaRTL != Mmma())
 	{
@@ -957,19 +2084,27 @@ int SystolicArraySim::ExecRtl(bool fastTransient, bool fastTransientTest)
 			return -1;
 		}
 
+		if(nullptr != FmaInputs_)
+		{
+			FmaInputs_->emplace_back();
+			FmaInputs_->back().Cycle = CycleCnt_;
+			FmaInputs_->back().Clk = Tb->clk;
+			FmaInputGet(Tb, FmaInputsIndex_, &FmaInputs_->back());
+		}
+
 		// Fault injection
 		if(fiMode::Transient == FaultRTL_.Mode)
 		{
 			if(CycleCnt_ == FaultRTLTransCycle_)
 			{
 				sasDebug("Cycle %lu: Setting transient fault\n", CycleCnt_);
-				if(!fastTransientTest && FiRtlApply(TbVoid_, FaultRTL_.ModuleInstanceChain, FaultRTL_.AssignUUID, FaultRTL_.BitPos))
+				if(!fastTransientTest && FiRtlApply(Tb, FaultRTL_.ModuleInstanceChain, FaultRTL_.AssignUUID, FaultRTL_.BitPos))
 				{
 					sasError("FiRtlApply failed\n");
 					return -1;
 				}
 			}
-			else if(FiRtlReset(TbVoid_))
+			else if(fiSignalsEn && FiRtlReset(Tb))
 			{
 				sasError("FiRtlReset failed\n");
 				return -1;
@@ -1066,224 +2201,1345 @@ int SystolicArraySim::ExecRtl(bool fastTransient, bool fastTransientTest)
 	return 0;
 }
 
-static std::shared_ptr<double[]> randomMatrix(size_t M, size_t N, size_t stride)
+int SystolicArraySim::ExecRtlBatch(const std::vector<faultRTL_t> &faults, const std::vector<size_t> &cycles,
+		const double * matC, const std::vector<double *> &matCs, bool fastTransient, std::vector<bool> * errorsDetected)
+{
+	if((faults.size() != cycles.size()) || (faults.size() != matCs.size()))
+	{
+		sasError("Expected one cycle and C per fault\n");
+		return -1;
+	}
+
+	if(JobQueue_.empty())
+	{
+		return 0;
+	}
+
+	if(JobQueueReadBeforeWrite(JobQueue_))
+	{
+		sasError("Read before write in jobqueue\n");
+		return -1;
+	}
+
+	const size_t cyclesRequired = CyclesRequired(JobQueue_.size());
+	for(size_t run = 0; run < faults.size(); run++)
+	{
+		if((fiMode::Transient == faults[run].Mode) && (cyclesRequired <= cycles[run]))
+		{
+			sasError("Cycle %lu outside of job queue (%lu cycles)\n", cycles[run], cyclesRequired);
+			return -1;
+		}
+	}
+
+	return fiRegionNetlist(FiRegion_, [&](auto * netlist)
+	{
+		return ExecRtlBatchTb(netlist, faults, cycles, matC, matCs, fastTransient, errorsDetected);
+	});
+}
+
+// Runs of ExecRtlBatch on the FI region's netlist (testBench)
+template <typename testBench>
+int SystolicArraySim::ExecRtlBatchTb(const testBench * type, const std::vector<faultRTL_t> &faults, const std::vector<size_t> &cycles,
+		const double * matC, const std::vector<double *> &matCs, bool fastTransient, std::vector<bool> * errorsDetected)
+{
+	while(BatchTbVoid_.size() < faults.size())
+	{
+		BatchTbVoid_.push_back((void *) ModelNew<testBench>());
+	}
+
+	// Every run has its own copy of the job queue, writing to its C
+	typedef struct {
+		testBench * Tb;
+		std::deque<queueEntry_t> Jobs;
+		bool Active;
+	} run_t;
+
+	std::vector<run_t> runs(faults.size());
+	for(size_t run = 0; run < faults.size(); run++)
+	{
+		runs[run].Tb = (testBench*) BatchTbVoid_[run];
+		runs[run].Jobs = JobQueue_;
+		runs[run].Active = true;
+
+		for(auto &entry : runs[run].Jobs)
+		{
+			if(entry.Job.MatC < matC)
+			{
+				sasError("Job's C not in matrix at matC\n");
+				return -1;
+			}
+
+			entry.Job.MatC = matCs[run] + (entry.Job.MatC - matC);
+		}
+
+		const int fiRet = (fiMode::Permanent == faults[run].Mode) ?
+				FiRtlApply(runs[run].Tb, faults[run].ModuleInstanceChain, faults[run].AssignUUID, faults[run].BitPos) :
+				FiRtlReset(runs[run].Tb);
+		if(fiRet)
+		{
+			sasError("FiRtlApply failed\n");
+			return -1;
+		}
+
+		runs[run].Tb->clk = 1;
+	}
+
+	JobQueue_.clear();
+
+	if(nullptr != errorsDetected)
+	{
+		errorsDetected->assign(faults.size(), false);
+	}
+
+	size_t activeCnt = runs.size();
+	for(size_t cycle = 0; 0 < activeCnt; cycle++)
+	{
+		// First active run encodes the operands
+		const testBench * operandTb = nullptr;
+
+		for(size_t run = 0; run < runs.size(); run++)
+		{
+			if(!runs[run].Active)
+			{
+				continue;
+			}
+
+			testBench * Tb = runs[run].Tb;
+			Tb->clk = Tb->clk ? 0 : 1;
+
+			if(IoSet(Tb, &runs[run].Jobs, Tb->clk, operandTb))
+			{
+				sasError("inputSet failed\n");
+				return -1;
+			}
+
+			if(nullptr == operandTb)
+			{
+				operandTb = Tb;
+			}
+
+			if(fiMode::Transient == faults[run].Mode)
+			{
+				const int fiRet = (cycle == cycles[run]) ?
+						FiRtlApply(Tb, faults[run].ModuleInstanceChain, faults[run].AssignUUID, faults[run].BitPos) :
+						FiRtlReset(Tb);
+				if(fiRet)
+				{
+					sasError("FiRtlApply failed\n");
+					return -1;
+				}
+			}
+		}
+
+		for(size_t run = 0; run < runs.size(); run++)
+		{
+			if(!runs[run].Active)
+			{
+				continue;
+			}
+
+			testBench * Tb = runs[run].Tb;
+			Tb->eval();
+
+			if(Tb->error && (nullptr != errorsDetected))
+			{
+				(*errorsDetected)[run] = true;
+			}
+
+			std::deque<queueEntry_t> &jobs = runs[run].Jobs;
+
+			// Fault flushed out and no output of the front job yet? Then finish with the C model, see ExecRtlTb.
+			// The instance's own queue is empty during the batch, so it takes the run's jobs meanwhile
+			if(fastTransient && !jobs.empty() && (fiMode::Transient == faults[run].Mode) &&
+					(cycle + 1 > cycles[run] + JobCycleDone_ + 1) && (jobs.front().JobCycle < JobCycleOutputStart_))
+			{
+				for(auto &job: jobs)
+				{
+					job.JobCycle = 0;
+				}
+
+				const size_t cycleCnt = CycleCnt_;
+				JobQueue_.swap(jobs);
+				const int csimRet = ExecCsim();
+				JobQueue_.swap(jobs);
+				CycleCnt_ = cycleCnt;
+
+				if(csimRet)
+				{
+					sasError("ExecCsim failed\n");
+					return -1;
+				}
+			}
+
+			if(jobs.empty())
+			{
+				runs[run].Active = false;
+				activeCnt--;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static std::shared_ptr<double[]> randomMatrix(size_t M, size_t N, size_t stride)
+{
+	if(stride < N)
+	{
+		sasError("Stride can't be smaller than N\n");
+		return nullptr;
+	}
+
+	const size_t elementCnt = M * stride;
+	std::shared_ptr<double[]> out(new double[elementCnt]);
+	if(nullptr == out)
+	{
+		sasError("malloc failed\n");
+		return nullptr;
+	}
+
+	// might as well set all values to something
+	for(size_t index = 0; index < elementCnt; index++)
+	{
+		out[index] = randomDouble(-unitTestExponentRange, unitTestExponentRange, 0.1);
+	}
+
+	return out;
+}
+
+// Expected and got row major. Unit tests compute expected in a different order, so within tolerance
+template <typename T>
+static bool resultCorrect(const double * expected, T got, size_t rowCnt, size_t colCnt)
+{
+	static thread_local ResultCompare compare;
+	compare.Compare(expected, colCnt, 1, &got[0], colCnt, 1, rowCnt, colCnt);
+
+	sasDebug("Corrupted %lu, Largest Rel. Diff %.*f, Abs. Diff %.*f\n", compare.CorruptedCnt(),
+			DBL_DECIMAL_DIG, compare.MaxRelError(), DBL_DECIMAL_DIG, compare.MaxAbsError());
+
+	if(compare.MaxRelError() <= unitTestRelTolerance)
+	{
+		return true;
+	}
+
+	// Report the first element beyond tolerance (NaN compares as beyond)
+	for(size_t index = 0; index < rowCnt * colCnt; index++)
+	{
+		const double diff = fabs(expected[index] - got[index]);
+		const double relDiff = diff / fabs(expected[index]);
+		if(compare.Corrupted(index / colCnt, index % colCnt) && !(relDiff <= unitTestRelTolerance))
+		{
+			sasError("Index %lu (row %lu, col %lu): Got %f, expected %f (diff %.*f, rel. diff %.*f)\n",
+					index, index / colCnt, index % colCnt, got[index], expected[index],
+					DBL_DECIMAL_DIG, diff, DBL_DECIMAL_DIG, relDiff);
+			break;
+		}
+	}
+
+#if DEBUG_VERBOSE
+	sasDebug("Got:\n");
+	matrixPrint(&got[0], rowCnt, colCnt, colCnt);
+	sasDebug("Expected:\n");
+	matrixPrint(expected, rowCnt, colCnt, colCnt);
+#endif // DEBUG_VERBOSE
+
+	return false;
+}
+
+int SystolicArraySim::MmaTest(size_t mCnt, size_t nCnt, bool cSim, bool fiEn, bool fastTrans, bool FastTransTest)
+{
+	// One instance per thread, reset like a newly constructed one: Saves constructing the models per case
+	static thread_local SystolicArraySim sysArraySim(0);
+	sysArraySim.Reset(randomBits());
+
+	const size_t rowCnt = mCnt * sysArraySim.Mmma();
+	const size_t colCnt = nCnt * sysArraySim.Nmma();
+
+	std::shared_ptr<double[]> matA = randomMatrix(rowCnt, sysArraySim.Kmma(), sysArraySim.Kmma());
+	std::shared_ptr<double[]> matB = randomMatrix(sysArraySim.Kmma(), colCnt, colCnt);
+	std::shared_ptr<double[]> matC = randomMatrix(rowCnt, colCnt, colCnt);
+
+	std::vector<double> expected(rowCnt * colCnt);
+	memcpy(expected.data(), matC.get(), sizeof(double) * rowCnt * colCnt);
+	for(size_t row = 0; row < rowCnt; row++)
+	{
+		for(size_t col = 0; col < colCnt; col++)
+		{
+			for(size_t sum = 0; sum < sysArraySim.Kmma(); sum++)
+			{
+				expected[row * colCnt + col] += matA[row * sysArraySim.Kmma() + sum] * matB[sum * colCnt + col];
+			}
+		}
+	}
+
+	for(size_t jobm = 0; jobm < mCnt; jobm++)
+	{
+		for(size_t jobn = 0; jobn < nCnt; jobn++)
+		{
+			job_t jobStr = {
+					matA.get() + jobm * sysArraySim.Mmma() * sysArraySim.Kmma(), sysArraySim.Kmma(),
+					matB.get() + jobn * sysArraySim.Nmma(), nCnt * sysArraySim.Nmma(),
+					matC.get() + jobm * sysArraySim.Mmma() * nCnt * sysArraySim.Nmma() + jobn * sysArraySim.Nmma(), nCnt * sysArraySim.Nmma()};
+
+			sysArraySim.DispatchMma(jobStr);
+		}
+	}
+
+	faultRTL_t faultRTL;
+	if(fiEn)
+	{
+		faultRTL = sysArraySim.FiSetRTL(fiMode::Transient);
+		if(fiMode::None == faultRTL.Mode)
+		{
+			sasError("FiSetRTL failed\n");
+			return -1;
+		}
+	}
+
+	if(cSim)
+	{
+		if(sysArraySim.ExecCsim())
+		{
+			sasError("ExecCsim failed\n");
+			return -1;
+		}
+	}
+	else
+	{
+		if(sysArraySim.ExecRtl(fastTrans, FastTransTest))
+		{
+			sasError("ExecCycle failed\n");
+			return -1;
+		}
+
+		if(!fiEn && sysArraySim.ErrorDetected())
+		{
+			sasError("False positive error detected\n");
+			return -1;
+		}
+	}
+
+	// Check if result correct
+	if(!resultCorrect(expected.data(), matC, rowCnt, colCnt))
+	{
+		sasError("Output not correct\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+int SystolicArraySim::TileTest(bool cSim)
+{
+	SystolicArraySim sysArraySim;
+
+	std::shared_ptr<double[]> matA = randomMatrix(sysArraySim.Mtile(), sysArraySim.Ktile(), sysArraySim.Ktile());
+	std::shared_ptr<double[]> matB = randomMatrix(sysArraySim.Ktile(), sysArraySim.Ntile(), sysArraySim.Ntile());
+	std::shared_ptr<double[]> matC = randomMatrix(sysArraySim.Mtile(), sysArraySim.Ntile(), sysArraySim.Ntile());
+
+	std::vector<double> expected(sysArraySim.Mtile() * sysArraySim.Ntile());
+	memcpy(expected.data(), matC.get(), sizeof(double) * sysArraySim.Mtile() * sysArraySim.Ntile());
+	for(size_t row = 0; row < sysArraySim.Mtile(); row++)
+	{
+		for(size_t col = 0; col < sysArraySim.Ntile(); col++)
+		{
+			for(size_t sum = 0; sum < sysArraySim.Ktile(); sum++)
+			{
+				expected[row * sysArraySim.Ntile() + col] += matA[row * sysArraySim.Ktile() + sum] * matB[sum * sysArraySim.Ntile() + col];
+			}
+		}
+	}
+
+	job_t job = {
+			matA.get(), sysArraySim.Ktile(),
+			matB.get(), sysArraySim.Ntile(),
+			matC.get(), sysArraySim.Ntile()
+	};
+
+	sysArraySim.DispatchTile(job);
+
+	if(cSim)
+	{
+		if(sysArraySim.ExecCsim())
+		{
+			sasError("ExecCsim failed\n");
+			return -1;
+		}
+	}
+	else
+	{
+		if(sysArraySim.ExecRtl())
+		{
+			sasError("ExecCycle failed\n");
+			return -1;
+		}
+	}
+
+	// Check if result correct
+	if(!resultCorrect(expected.data(), matC, sysArraySim.Mtile(), sysArraySim.Ntile()))
+	{
+		sasError("Output not correct\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+// Column-major A and C, row-major B with padded strides (as passed in by BLAS)
+int SystolicArraySim::StridedTileTest(bool cSim)
+{
+	SystolicArraySim sysArraySim;
+
+	const size_t M = sysArraySim.Mtile();
+	const size_t K = sysArraySim.Ktile();
+	const size_t N = sysArraySim.Ntile();
+
+	const size_t lda = M + 3;
+	const size_t ldb = N + 1;
+	const size_t ldc = M + 5;
+
+	std::shared_ptr<double[]> matA = randomMatrix(K, lda, lda); // column-major
+	std::shared_ptr<double[]> matB = randomMatrix(K, ldb, ldb); // row-major
+	std::shared_ptr<double[]> matC = randomMatrix(N, ldc, ldc); // column-major
+
+	std::vector<double> expected(M * N);
+	for(size_t row = 0; row < M; row++)
+	{
+		for(size_t col = 0; col < N; col++)
+		{
+			expected[row * N + col] = matC[row + col * ldc];
+			for(size_t sum = 0; sum < K; sum++)
+			{
+				expected[row * N + col] += matA[row + sum * lda] * matB[sum * ldb + col];
+			}
+		}
+	}
+
+	job_t job = {
+			matA.get(), 1,
+			matB.get(), ldb,
+			matC.get(), 1,
+			lda, 1, ldc};
+
+	sysArraySim.DispatchTile(job);
+
+	if(cSim)
+	{
+		if(sysArraySim.ExecCsim())
+		{
+			sasError("ExecCsim failed\n");
+			return -1;
+		}
+	}
+	else
+	{
+		if(sysArraySim.ExecRtl())
+		{
+			sasError("ExecCycle failed\n");
+			return -1;
+		}
+	}
+
+	std::vector<double> got(M * N);
+	for(size_t row = 0; row < M; row++)
+	{
+		for(size_t col = 0; col < N; col++)
+		{
+			got[row * N + col] = matC[row + col * ldc];
+		}
+	}
+
+	// Check if result correct
+	if(!resultCorrect(expected.data(), got.data(), M, N))
+	{
+		sasError("Output not correct\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+// Two instances with the same permanent fault have to compute the same (faulty) result
+int SystolicArraySim::FiCopyTest(bool cSim)
+{
+	SystolicArraySim sysArraySim;
+	SystolicArraySim sysArraySimCopy;
+
+	const size_t M = sysArraySim.Mmma();
+	const size_t K = sysArraySim.Kmma();
+	const size_t N = sysArraySim.Nmma();
+
+	std::shared_ptr<double[]> matA = randomMatrix(M, K, K);
+	std::shared_ptr<double[]> matB = randomMatrix(K, N, N);
+	std::shared_ptr<double[]> matC = randomMatrix(M, N, N);
+
+	std::vector<double> matCCopy(matC.get(), matC.get() + M * N);
+
+	job_t job = {matA.get(), K, matB.get(), N, matC.get(), N};
+	job_t jobCopy = {matA.get(), K, matB.get(), N, matCCopy.data(), N};
+
+	sysArraySim.DispatchMma(job);
+	sysArraySimCopy.DispatchMma(jobCopy);
+
+	if(cSim)
+	{
+		const faultCsim_t fault = sysArraySim.FiSetCsim(
+				fiCsimPlace::Everywhere, fiBits::Everywhere, fiCorruption::Flip, fiMode::Permanent);
+		if(fiCsimPlace::None == fault.Place)
+		{
+			sasError("FiSetCsim failed\n");
+			return -1;
+		}
+
+		if(sysArraySimCopy.FiSetCsim(fault))
+		{
+			sasError("FiSetCsim (copy) failed\n");
+			return -1;
+		}
+
+		// The affected FMA and input are part of the fault, i.e. the instances' Prngs don't matter
+		if(sysArraySim.ExecCsim())
+		{
+			sasError("ExecCsim failed\n");
+			return -1;
+		}
+
+		if(sysArraySimCopy.ExecCsim())
+		{
+			sasError("ExecCsim (copy) failed\n");
+			return -1;
+		}
+	}
+	else
+	{
+		const faultRTL_t fault = sysArraySim.FiSetRTL(fiMode::Permanent);
+		if(fiMode::None == fault.Mode)
+		{
+			sasError("FiSetRTL failed\n");
+			return -1;
+		}
+
+		if(sysArraySimCopy.FiSetRTL(fault))
+		{
+			sasError("FiSetRTL (copy) failed\n");
+			return -1;
+		}
+
+		if(sysArraySim.ExecRtl() || sysArraySimCopy.ExecRtl())
+		{
+			sasError("ExecRtl failed\n");
+			return -1;
+		}
+	}
+
+	if(memcmp(matC.get(), matCCopy.data(), sizeof(double) * M * N))
+	{
+		sasError("Outputs of instances with same fault differ\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+// A transient fault replayed with its cycle on another instance has to compute the same (faulty) result
+int SystolicArraySim::ReplayTest(bool cSim)
+{
+	SystolicArraySim sysArraySim;
+	SystolicArraySim sysArraySimReplay;
+
+	// Consecutive jobs write to different C, see JobQueueReadBeforeWrite
+	const size_t mmaMultipleCnt = 2;
+	const size_t M = mmaMultipleCnt * sysArraySim.Mmma();
+	const size_t K = 2 * sysArraySim.Kmma();
+	const size_t N = mmaMultipleCnt * sysArraySim.Nmma();
+
+	std::shared_ptr<double[]> matA = randomMatrix(M, K, K);
+	std::shared_ptr<double[]> matB = randomMatrix(K, N, N);
+	std::shared_ptr<double[]> matC = randomMatrix(M, N, N);
+
+	std::vector<double> matCReplay(matC.get(), matC.get() + M * N);
+
+	for(size_t sum = 0; sum < K; sum += sysArraySim.Kmma())
+	{
+		job_t job = {matA.get() + sum, K, matB.get() + sum * N, N, matC.get(), N};
+		job_t jobReplay = {matA.get() + sum, K, matB.get() + sum * N, N, matCReplay.data(), N};
+
+		sysArraySim.DispatchMma(job, mmaMultipleCnt, mmaMultipleCnt);
+		sysArraySimReplay.DispatchMma(jobReplay, mmaMultipleCnt, mmaMultipleCnt);
+	}
+
+	if(cSim)
+	{
+		const faultCsim_t fault = sysArraySim.FiSetCsim(
+				fiCsimPlace::Everywhere, fiBits::Everywhere, fiCorruption::Flip, fiMode::Transient);
+		if(fiCsimPlace::None == fault.Place)
+		{
+			sasError("FiSetCsim failed\n");
+			return -1;
+		}
+
+		if(sysArraySimReplay.FiSetCsim(fault, sysArraySim.FaultCsimCycle()) ||
+				(sysArraySim.FaultCsimCycle() != sysArraySimReplay.FaultCsimCycle()))
+		{
+			sasError("FiSetCsim (replay) failed\n");
+			return -1;
+		}
+
+		// Nothing is drawn during execution, see FiCopyTest
+		if(sysArraySim.ExecCsim() || sysArraySimReplay.ExecCsim())
+		{
+			sasError("ExecCsim failed\n");
+			return -1;
+		}
+	}
+	else
+	{
+		const faultRTL_t fault = sysArraySim.FiSetRTL(fiMode::Transient);
+		if(fiMode::None == fault.Mode)
+		{
+			sasError("FiSetRTL failed\n");
+			return -1;
+		}
+
+		if(sysArraySimReplay.FiSetRTL(fault, sysArraySim.FaultRTLCycle()) ||
+				(sysArraySim.FaultRTLCycle() != sysArraySimReplay.FaultRTLCycle()))
+		{
+			sasError("FiSetRTL (replay) failed\n");
+			return -1;
+		}
+
+		if(sysArraySim.ExecRtl() || sysArraySimReplay.ExecRtl())
+		{
+			sasError("ExecRtl failed\n");
+			return -1;
+		}
+	}
+
+	if(memcmp(matC.get(), matCReplay.data(), sizeof(double) * M * N))
+	{
+		sasError("Outputs of recorded and replayed fault differ\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+// Fma faults corrupt exactly the operations of the faulty FMA in flight, also those of the previous job
+int SystolicArraySim::DictTest()
+{
+	SystolicArraySim sysArraySim;
+	SystolicArraySim sysArraySimRef;
+
+	// Bit 1 of the site flips the mantissa sign of all operations in flight in phase 0, phase 1 is masked.
+	// Only for this instance: DictEnable would apply to the cases running in parallel
+	std::shared_ptr<FaultDictionary> dict(new FaultDictionary);
+	FaultDictionary::pattern_t flipped = {};
+	for(size_t stage = 0; stage < FaultDictionary::Stages; stage++)
+	{
+		flipped[stage * FaultDictionary::Words + 1] = 1 << (53 - 32);
+	}
+
+	const size_t site = dict->SiteAdd({1}, 7, 2);
+	dict->Record(site, 1, 0, flipped);
+	dict->Record(site, 1, 1, FaultDictionary::pattern_t());
+	sysArraySim.DictUse(dict);
+
+	const size_t M = sysArraySim.Mmma();
+	const size_t K = sysArraySim.Kmma();
+	const size_t N = sysArraySim.Nmma();
+
+	// Without zeros and overflows, flipping the mantissa sign always changes the value
+	std::vector<double> matA(M * K);
+	std::vector<double> matB(K * N);
+	std::vector<double> matC(2 * M * N);
+	for(auto mat : {&matA, &matB, &matC})
+	{
+		for(auto &elem : *mat)
+		{
+			elem = randomDouble(-5, 5, 0);
+		}
+	}
+
+	faultCsim_t fault;
+	fault.Place = fiCsimPlace::Fma;
+	fault.Corruption = fiCorruption::Flip;
+	fault.Mode = fiMode::Transient;
+	fault.Row = 5;
+	fault.Fma = 3;
+	fault.Site = site;
+	fault.SiteBit = 1;
+	fault.SitePattern = 0;
+
+	// FMA 3 takes column n of job j in cycle 18 * j + 13 + 2 * n: A fault in cycle 35 (phase 0) hits
+	// columns 0 to 2 of job 1 in stages 2 to 0, and columns 6 and 7 of job 0 in stages 5 and 4
+	int ret = 0;
+	for(const size_t cycle : {35, 36})
+	{
+		std::vector<double> matCFi = matC;
+		std::vector<double> matCRef = matC;
+		for(size_t jobNr = 0; jobNr < 2; jobNr++)
+		{
+			sysArraySim.DispatchMma({matA.data(), K, matB.data(), N, matCFi.data() + jobNr * M * N, N});
+			sysArraySimRef.DispatchMma({matA.data(), K, matB.data(), N, matCRef.data() + jobNr * M * N, N});
+		}
+
+		if(sysArraySim.FiSetCsim(fault, cycle) || sysArraySim.ExecCsim() || sysArraySim.FiResetCsim() || sysArraySimRef.ExecCsim())
+		{
+			sasError("Fma fault simulation failed\n");
+			ret = -1;
+			break;
+		}
+
+		for(size_t row = 0; row < 2 * M; row++)
+		{
+			for(size_t col = 0; col < N; col++)
+			{
+				const bool expected = (35 == cycle) && (fault.Row == row % M) && ((row < M) ? (6 <= col) : (2 >= col));
+				if(expected != (0 != memcmp(&matCFi[row * N + col], &matCRef[row * N + col], sizeof(double))))
+				{
+					sasError("Cycle %lu: C[%lu][%lu] %s\n", cycle, row, col, expected ? "not corrupted" : "corrupted");
+					ret = -1;
+				}
+			}
+		}
+	}
+
+	// Drawn faults are characterized ones
+	sysArraySim.DispatchMma({matA.data(), K, matB.data(), N, matC.data(), N});
+	const faultCsim_t drawn = sysArraySim.FiSetCsim(fiCsimPlace::Fma, fiBits::Everywhere, fiCorruption::Flip, fiMode::Transient);
+	if((fiCsimPlace::Fma != drawn.Place) || (site != drawn.Site) || (1 != drawn.SiteBit) || (0 != drawn.SitePattern) ||
+			(sysArraySim.CyclesRequired(1) <= sysArraySim.FaultCsimCycle()))
+	{
+		sasError("Unexpected Fma fault drawn\n");
+		ret = -1;
+	}
+
+	return ret;
+}
+
+// Characterized sites of the FMAs have patterns corrupting the output, i.e. their faults reach the FMA model.
+// Needs the FMA instances of the netlist (CoiEnable, testNetlist --coi)
+int SystolicArraySim::DictCharacterizeTest()
+{
+#ifdef NETLIST
+	if(coiFmaInstances.empty())
+	{
+		sasInfo("No FMA instances set (testNetlist --coi), skipped\n");
+		return 0;
+	}
+
+	FaultDictionary dict;
+	if(DictCharacterize(&dict, coiFmaInstances, 8, 4, 5))
+	{
+		sasError("DictCharacterize failed\n");
+		return -1;
+	}
+
+	size_t unmasked = 0;
+	for(size_t site = 0; site < dict.Sites(); site++)
+	{
+		unmasked += dict.Unmasked(site);
+	}
+
+	if(0 == unmasked)
+	{
+		sasError("All patterns of %lu sites masked, faults don't reach the FMA model\n", dict.Sites());
+		return -1;
+	}
+
+	return 0;
+#else // !NETLIST
+	sasError("Only available with NETLIST\n");
+	return -1;
+#endif // !NETLIST
+}
+
+// Every run of a batch has to compute the same result as ExecRtl of an own instance with the same fault
+int SystolicArraySim::BatchTest(bool fiEn, bool fastTransient)
+{
+	SystolicArraySim sysArraySim;
+
+	const size_t mmaMultipleCnt = 2;
+	const size_t M = mmaMultipleCnt * sysArraySim.Mmma();
+	const size_t K = 2 * sysArraySim.Kmma();
+	const size_t N = mmaMultipleCnt * sysArraySim.Nmma();
+	const size_t runCnt = 4;
+
+	std::shared_ptr<double[]> matA = randomMatrix(M, K, K);
+	std::shared_ptr<double[]> matB = randomMatrix(K, N, N);
+	std::shared_ptr<double[]> matC = randomMatrix(M, N, N);
+	const std::vector<double> matCOrig(matC.get(), matC.get() + M * N);
+
+	std::vector<std::vector<double>> matCsRef(runCnt, matCOrig);
+	std::vector<std::vector<double>> matCsBatch(runCnt, matCOrig);
+	std::vector<double *> matCs;
+	std::vector<faultRTL_t> faults(runCnt);
+	std::vector<size_t> cycles(runCnt, 0);
+	std::vector<bool> errorsRef(runCnt, false);
+
+	// Run 0 is fault free
+	for(size_t run = 0; run < runCnt; run++)
+	{
+		SystolicArraySim sysArraySimRef;
+		for(size_t sum = 0; sum < K; sum += sysArraySim.Kmma())
+		{
+			job_t job = {matA.get() + sum, K, matB.get() + sum * N, N, matCsRef[run].data(), N};
+			sysArraySimRef.DispatchMma(job, mmaMultipleCnt, mmaMultipleCnt);
+		}
+
+		if(fiEn && (0 != run))
+		{
+			faults[run] = sysArraySimRef.FiSetRTL(fiMode::Transient);
+			if(fiMode::None == faults[run].Mode)
+			{
+				sasError("FiSetRTL failed\n");
+				return -1;
+			}
+
+			cycles[run] = sysArraySimRef.FaultRTLCycle();
+		}
+
+		if(sysArraySimRef.ExecRtl())
+		{
+			sasError("ExecRtl failed\n");
+			return -1;
+		}
+
+		errorsRef[run] = sysArraySimRef.ErrorDetected();
+		matCs.push_back(matCsBatch[run].data());
+	}
+
+	for(size_t sum = 0; sum < K; sum += sysArraySim.Kmma())
+	{
+		job_t job = {matA.get() + sum, K, matB.get() + sum * N, N, matC.get(), N};
+		sysArraySim.DispatchMma(job, mmaMultipleCnt, mmaMultipleCnt);
+	}
+
+	std::vector<bool> errorsDetected;
+	if(sysArraySim.ExecRtlBatch(faults, cycles, matC.get(), matCs, fastTransient, &errorsDetected))
+	{
+		sasError("ExecRtlBatch failed\n");
+		return -1;
+	}
+
+	if(memcmp(matC.get(), matCOrig.data(), sizeof(double) * M * N))
+	{
+		sasError("ExecRtlBatch wrote to the jobs' C\n");
+		return -1;
+	}
+
+	for(size_t run = 0; run < runCnt; run++)
+	{
+		// Finishing with the C model rounds differently than the RTL. It only takes the jobs after the
+		// flushed out fault, i.e. faulty lanes differ by rounding at most
+		const bool csimEn = fastTransient && (fiMode::None != faults[run].Mode);
+		bool differ = errorsRef[run] != errorsDetected[run];
+		for(size_t index = 0; !differ && (index < M * N); index++)
+		{
+			const double ref = matCsRef[run][index];
+			const double batch = matCsBatch[run][index];
+			differ = memcmp(&ref, &batch, sizeof(double)) &&
+					(!csimEn || !(0.000000001 * std::max(fabs(ref), 1.0) >= fabs(batch - ref)));
+		}
+
+		if(differ)
+		{
+			sasError("Run %lu of batch differs from single run\n", run);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// Fault free runs on the RTL model must match the netlist bit by bit, also within the transient window of fastTransientTest
+int SystolicArraySim::ModelTest()
+{
+	const size_t mmaMultipleCnt = 2;
+	SystolicArraySim sysArraySimFault;
+	const size_t M = mmaMultipleCnt * sysArraySimFault.Mmma();
+	const size_t K = 2 * sysArraySimFault.Kmma();
+	const size_t N = mmaMultipleCnt * sysArraySimFault.Nmma();
+
+	std::shared_ptr<double[]> matA = randomMatrix(M, K, K);
+	std::shared_ptr<double[]> matB = randomMatrix(K, N, N);
+	std::shared_ptr<double[]> matC = randomMatrix(M, N, N);
+
+	// Transient fault to take the window from
+	for(size_t sum = 0; sum < K; sum += sysArraySimFault.Kmma())
+	{
+		job_t job = {matA.get() + sum, K, matB.get() + sum * N, N, matC.get(), N};
+		sysArraySimFault.DispatchMma(job, mmaMultipleCnt, mmaMultipleCnt);
+	}
+
+	const faultRTL_t fault = sysArraySimFault.FiSetRTL(fiMode::Transient);
+	if(fiMode::None == fault.Mode)
+	{
+		sasError("FiSetRTL failed\n");
+		return -1;
+	}
+
+	const size_t cycle = sysArraySimFault.FaultRTLCycle();
+
+	for(const bool fastTransientTest : {false, true})
+	{
+		std::vector<std::vector<double>> matCs(2, std::vector<double>(matC.get(), matC.get() + M * N));
+		std::vector<bool> errors(2, false);
+
+		for(size_t model = 0; model < 2; model++)
+		{
+			SystolicArraySim sysArraySim;
+			sysArraySim.FastModelEn(0 == model);
+
+			for(size_t sum = 0; sum < K; sum += sysArraySim.Kmma())
+			{
+				job_t job = {matA.get() + sum, K, matB.get() + sum * N, N, matCs[model].data(), N};
+				sysArraySim.DispatchMma(job, mmaMultipleCnt, mmaMultipleCnt);
+			}
+
+			if(fastTransientTest && sysArraySim.FiSetRTL(fault, cycle))
+			{
+				sasError("FiSetRTL failed\n");
+				return -1;
+			}
+
+			if(sysArraySim.ExecRtl(fastTransientTest, fastTransientTest))
+			{
+				sasError("ExecRtl failed\n");
+				return -1;
+			}
+
+			errors[model] = sysArraySim.ErrorDetected();
+		}
+
+		if(memcmp(matCs[0].data(), matCs[1].data(), sizeof(double) * M * N) || (errors[0] != errors[1]))
+		{
+			sasError("RTL model differs from netlist (fastTransientTest = %i)\n", fastTransientTest);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// The netlists of all linked FI regions compute as the fully instrumented one, and simulate faults drawn from their sites
+int SystolicArraySim::RegionTest()
+{
+	SystolicArraySim sysArraySimFull;
+	if(0 != strcmp("SystolicArray", sysArraySimFull.FiRegion()))
+	{
+		sasError("Expected the fully instrumented netlist by default, have %s\n", sysArraySimFull.FiRegion());
+		return -1;
+	}
+
+	if(0 == sysArraySimFull.FiRegionSet("NoSuchRegion"))
+	{
+		sasError("Unknown FI region accepted\n");
+		return -1;
+	}
+
+	const size_t mmaMultipleCnt = 2;
+	const size_t M = mmaMultipleCnt * sysArraySimFull.Mmma();
+	const size_t K = 2 * sysArraySimFull.Kmma();
+	const size_t N = mmaMultipleCnt * sysArraySimFull.Nmma();
+
+	std::shared_ptr<double[]> matA = randomMatrix(M, K, K);
+	std::shared_ptr<double[]> matB = randomMatrix(K, N, N);
+	std::shared_ptr<double[]> matC = randomMatrix(M, N, N);
+
+	// Fault free runs on the netlist of sysArraySim
+	auto netlistRun = [&](SystolicArraySim * sysArraySim, fiMode mode, std::vector<double> * out)
+	{
+		out->assign(matC.get(), matC.get() + M * N);
+		sysArraySim->FastModelEn(false);
+
+		for(size_t sum = 0; sum < K; sum += sysArraySim->Kmma())
+		{
+			job_t job = {matA.get() + sum, K, matB.get() + sum * N, N, out->data(), N};
+			sysArraySim->DispatchMma(job, mmaMultipleCnt, mmaMultipleCnt);
+		}
+
+		if((fiMode::None != mode) && (fiMode::None == sysArraySim->FiSetRTL(mode).Mode))
+		{
+			sasError("FiSetRTL failed\n");
+			return -1;
+		}
+
+		if(sysArraySim->ExecRtl())
+		{
+			sasError("ExecRtl failed\n");
+			return -1;
+		}
+
+		if((fiMode::None != mode) && sysArraySim->FiResetRTL())
+		{
+			sasError("FiResetRTL failed\n");
+			return -1;
+		}
+
+		return 0;
+	};
+
+	std::vector<double> matCFull;
+	if(netlistRun(&sysArraySimFull, fiMode::None, &matCFull))
+	{
+		return -1;
+	}
+
+	for(const std::string &region : FiRegions())
+	{
+		SystolicArraySim sysArraySim;
+		if(sysArraySim.FiRegionSet(region.c_str()) || (region != sysArraySim.FiRegion()))
+		{
+			sasError("FiRegionSet %s failed\n", region.c_str());
+			return -1;
+		}
+
+		for(const fiMode mode : {fiMode::None, fiMode::Permanent, fiMode::Transient})
+		{
+			std::vector<double> matCRegion;
+			if(netlistRun(&sysArraySim, mode, &matCRegion))
+			{
+				sasError("FI region %s, fiMode %i failed\n", region.c_str(), to_integer(mode));
+				return -1;
+			}
+
+			if((fiMode::None == mode) && memcmp(matCFull.data(), matCRegion.data(), sizeof(double) * M * N))
+			{
+				sasError("Netlist of FI region %s differs from the fully instrumented one\n", region.c_str());
+				return -1;
+			}
+		}
+	}
+
+	// Switching drops the models of the previous region
+	std::vector<double> matCSwitched;
+	if(sysArraySimFull.FiRegionSet(FiRegions().back().c_str()) || netlistRun(&sysArraySimFull, fiMode::None, &matCSwitched))
+	{
+		sasError("Switching the FI region failed\n");
+		return -1;
+	}
+
+	if(memcmp(matCFull.data(), matCSwitched.data(), sizeof(double) * M * N))
+	{
+		sasError("Netlist of FI region %s differs after switching\n", FiRegions().back().c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+// Transient faults inside the FMAs compute the same with the cone of influence simulation as on the netlist.
+// Needs the FMA instances of the netlist (CoiEnable, testNetlist --coi)
+int SystolicArraySim::CoiTest()
+{
+#ifdef NETLIST
+	if(coiFmaInstances.empty())
+	{
+		sasInfo("No FMA instances set (testNetlist --coi), skipped\n");
+		return 0;
+	}
+
+	const size_t mmaMultipleCnt = 2;
+	const size_t faultCnt = 8;
+	SystolicArraySim sysArraySimFault;
+	const size_t M = mmaMultipleCnt * sysArraySimFault.Mmma();
+	const size_t K = 2 * sysArraySimFault.Kmma();
+	const size_t N = mmaMultipleCnt * sysArraySimFault.Nmma();
+
+	std::shared_ptr<double[]> matA = randomMatrix(M, K, K);
+	std::shared_ptr<double[]> matB = randomMatrix(K, N, N);
+	std::shared_ptr<double[]> matC = randomMatrix(M, N, N);
+
+	// Draws the faults
+	for(size_t sum = 0; sum < K; sum += sysArraySimFault.Kmma())
+	{
+		job_t job = {matA.get() + sum, K, matB.get() + sum * N, N, matC.get(), N};
+		sysArraySimFault.DispatchMma(job, mmaMultipleCnt, mmaMultipleCnt);
+	}
+
+	for(size_t faultNr = 0; faultNr < faultCnt; faultNr++)
+	{
+		// Sites are drawn uniformly over assigns until one is inside an FMA
+		faultRTL_t fault;
+		bool fmaSite = false;
+		for(size_t draw = 0; !fmaSite && (draw < FaultSampler::MaxDraws); draw++)
+		{
+			fault = sysArraySimFault.FiSetRTL(fiMode::Transient);
+			if(fiMode::None == fault.Mode)
+			{
+				sasError("FiSetRTL failed\n");
+				return -1;
+			}
+
+			fmaSite = !fault.ModuleInstanceChain.empty() &&
+					(coiFmaInstances.end() != std::find(coiFmaInstances.begin(), coiFmaInstances.end(), fault.ModuleInstanceChain[0]));
+		}
+
+		if(!fmaSite)
+		{
+			sasError("No FMA site drawn, check the FMA instances\n");
+			return -1;
+		}
+
+		const size_t cycle = sysArraySimFault.FaultRTLCycle();
+
+		// Cone of influence simulation on the fast model, then the netlist only
+		std::vector<std::vector<double>> matCs(2, std::vector<double>(matC.get(), matC.get() + M * N));
+		std::vector<bool> errors(2, false);
+		for(size_t model = 0; model < 2; model++)
+		{
+			SystolicArraySim sysArraySim;
+			sysArraySim.FastModelEn(0 == model);
+
+			for(size_t sum = 0; sum < K; sum += sysArraySim.Kmma())
+			{
+				job_t job = {matA.get() + sum, K, matB.get() + sum * N, N, matCs[model].data(), N};
+				sysArraySim.DispatchMma(job, mmaMultipleCnt, mmaMultipleCnt);
+			}
+
+			if(sysArraySim.FiSetRTL(fault, cycle))
+			{
+				sasError("FiSetRTL failed\n");
+				return -1;
+			}
+
+			if(sysArraySim.ExecRtl())
+			{
+				sasError("ExecRtl failed\n");
+				return -1;
+			}
+
+			errors[model] = sysArraySim.ErrorDetected();
+		}
+
+		if(memcmp(matCs[0].data(), matCs[1].data(), sizeof(double) * M * N) || (errors[0] != errors[1]))
+		{
+			sasError("Cone of influence simulation differs from netlist: FMA instance %u, AssignUUID %u, bit %u, cycle %lu\n",
+					fault.ModuleInstanceChain[0], fault.AssignUUID, fault.BitPos, cycle);
+			return -1;
+		}
+	}
+
+	return 0;
+#else // !NETLIST
+	sasError("Only available with NETLIST\n");
+	return -1;
+#endif // !NETLIST
+}
+
+// Two Csim instances with the same seed have to choose the same transient fault and compute the same result
+int SystolicArraySim::SeedTest()
 {
-	if(stride < N)
+	const uint64_t seed = randomBits();
+	SystolicArraySim sysArraySim(seed);
+	SystolicArraySim sysArraySimSeeded(seed);
+
+	const size_t M = sysArraySim.Mmma();
+	const size_t K = sysArraySim.Kmma();
+	const size_t N = sysArraySim.Nmma();
+
+	std::shared_ptr<double[]> matA = randomMatrix(M, K, K);
+	std::shared_ptr<double[]> matB = randomMatrix(K, N, N);
+	std::shared_ptr<double[]> matC = randomMatrix(M, N, N);
+
+	std::vector<double> matCSeeded(matC.get(), matC.get() + M * N);
+
+	job_t job = {matA.get(), K, matB.get(), N, matC.get(), N};
+	job_t jobSeeded = {matA.get(), K, matB.get(), N, matCSeeded.data(), N};
+
+	for(size_t mma = 0; mma < 4; mma++)
 	{
-		sasError("Stride can't be smaller than N\n");
-		return nullptr;
+		sysArraySim.DispatchMma(job);
+		sysArraySimSeeded.DispatchMma(jobSeeded);
 	}
 
-	const size_t elementCnt = M * stride;
-	std::shared_ptr<double[]> out(new double[elementCnt]);
-	if(nullptr == out)
+	const faultCsim_t fault = sysArraySim.FiSetCsim(
+			fiCsimPlace::Everywhere, fiBits::Everywhere, fiCorruption::Flip, fiMode::Transient);
+	const faultCsim_t faultSeeded = sysArraySimSeeded.FiSetCsim(
+			fiCsimPlace::Everywhere, fiBits::Everywhere, fiCorruption::Flip, fiMode::Transient);
+
+	if((fiCsimPlace::None == fault.Place) || (fault.Place != faultSeeded.Place) || (fault.BitPos != faultSeeded.BitPos) ||
+			(fault.Row != faultSeeded.Row) || (sysArraySim.FaultCsimTransCycle_ != sysArraySimSeeded.FaultCsimTransCycle_))
 	{
-		sasError("malloc failed\n");
-		return nullptr;
+		sasError("Instances with same seed chose different faults\n");
+		return -1;
 	}
 
-	// might as well set all values to something
-	for(size_t index = 0; index < elementCnt; index++)
+	if(sysArraySim.ExecCsim() || sysArraySimSeeded.ExecCsim())
 	{
-		out[index] = randomDouble(-unitTestExponentRange, unitTestExponentRange, 0.1);
+		sasError("ExecCsim failed\n");
+		return -1;
 	}
 
-	return out;
-}
-
-template <typename T>
-static bool resultCorrect(const double * expected, T got, size_t rowCnt, size_t colCnt)
-{
-#if SAS_DEBUG
-	double largestDiff = 0;
-	double largestDiffExpectedVal = NAN;
-	double largestDiffActualVal = NAN;
-
-	double largestRelDiff = 0;
-	double largestRelDiffExpectedVal = NAN;
-	double largestRelDiffActualVal = NAN;
-#endif // SAS_DEBUG
-
-	for(size_t index = 0; index < rowCnt * colCnt; index++)
+	if(memcmp(matC.get(), matCSeeded.data(), sizeof(double) * M * N))
 	{
-		const double diff = fabs(expected[index] - got[index]);
+		sasError("Outputs of instances with same seed differ\n");
+		return -1;
+	}
 
-#if SAS_DEBUG
-		if(largestDiff < diff)
-		{
-			largestDiff = diff;
-			largestDiffExpectedVal = expected[index];
-			largestDiffActualVal = got[index];
-		}
-#endif // SAS_DEBUG
+	return 0;
+}
 
-		const double relDiff = diff / fabsf(expected[index]);
+// A reset instance draws the same fault and computes the same results as a new one with the same seed,
+// also when reset with jobs in flight: Its models are back in the state of newly constructed ones
+int SystolicArraySim::ResetTest()
+{
+	const uint64_t seed = randomBits();
+	SystolicArraySim sysArraySim(randomBits());
 
-#if SAS_DEBUG
-		if((largestRelDiff < relDiff) &&
-				((relDiff != std::numeric_limits<double>::infinity()) || (expected[index] != 0))) // Inf is only an error if expected != 0
-		{
-			largestRelDiff = relDiff;
-			largestRelDiffExpectedVal = expected[index];
-			largestRelDiffActualVal = got[index];
-		}
-#endif // SAS_DEBUG
+	const size_t M = sysArraySim.Mmma();
+	const size_t K = sysArraySim.Kmma();
+	const size_t N = sysArraySim.Nmma();
 
-		if(relDiff > unitTestRelTolerance)
-		{
-			sasError("Index %lu (row %lu, col %lu): Got %f, expected %f (diff %.*f, rel. diff %.*f)\n",
-					index, index / colCnt, index % colCnt, got[index], expected[index],
-					DBL_DECIMAL_DIG, diff, DBL_DECIMAL_DIG, relDiff);
+	std::shared_ptr<double[]> matA = randomMatrix(M, K, K);
+	std::shared_ptr<double[]> matB = randomMatrix(K, N, N);
+	std::shared_ptr<double[]> matC = randomMatrix(M, N, N);
 
-#if DEBUG_VERBOSE
-			sasDebug("Got:\n");
-			matrixPrint(matC, rowCnt, colCnt, colCnt);
-			sasDebug("Expected:\n");
-			matrixPrint(expected, rowCnt, colCnt, colCnt);
-#endif // DEBUG_VERBOSE
+	std::vector<double> out(matC.get(), matC.get() + M * N);
+	const job_t job = {matA.get(), K, matB.get(), N, out.data(), N};
 
-			return false;
-		}
+	// Create the models of ExecRtl, including the netlist in NETLIST builds
+	sysArraySim.DispatchMma(job);
+	if(sysArraySim.ExecRtl())
+	{
+		sasError("ExecRtl failed\n");
+		return -1;
 	}
 
-	sasDebug("Largest Rel. Diff %.*f (valExp %f, valAct %f), Abs. Diff %.*f (valExp %f, valAct %f)\n",
-			DBL_DECIMAL_DIG, largestRelDiff,	largestRelDiffExpectedVal, largestRelDiffActualVal,
-			DBL_DECIMAL_DIG, largestDiff,	largestDiffExpectedVal, largestDiffActualVal);
-
-	return true;
-}
-
-int SystolicArraySim::MmaTest(size_t mCnt, size_t nCnt, bool cSim, bool fiEn, bool fastTrans, bool FastTransTest)
-{
-	SystolicArraySim sysArraySim;
-
-	const size_t rowCnt = mCnt * sysArraySim.Mmma();
-	const size_t colCnt = nCnt * sysArraySim.Nmma();
-
-	std::shared_ptr<double[]> matA = randomMatrix(rowCnt, sysArraySim.Kmma(), sysArraySim.Kmma());
-	std::shared_ptr<double[]> matB = randomMatrix(sysArraySim.Kmma(), colCnt, colCnt);
-	std::shared_ptr<double[]> matC = randomMatrix(rowCnt, colCnt, colCnt);
+#ifdef NETLIST
+	sysArraySim.DispatchMma(job);
+	if(sysArraySim.ExecNetlist(false, false))
+	{
+		sasError("ExecNetlist failed\n");
+		return -1;
+	}
+#endif // NETLIST
 
-	std::vector<double> expected(rowCnt * colCnt);
-	memcpy(expected.data(), matC.get(), sizeof(double) * rowCnt * colCnt);
-	for(size_t row = 0; row < rowCnt; row++)
+	// Leave jobs in flight: Clock the models half way through two jobs as ExecRtlTb does,
+	// the queue keeps both
+	sysArraySim.DispatchMma(job);
+	sysArraySim.DispatchMma(job);
+	const size_t cyclesInFlight = sysArraySim.CyclesRequired(sysArraySim.JobQueue_.size()) / 2;
+	const auto inFlight = [&](auto * Tb)
 	{
-		for(size_t col = 0; col < colCnt; col++)
+		std::deque<queueEntry_t> jobs = sysArraySim.JobQueue_;
+		Tb->clk = 1;
+		for(size_t cycle = 0; cycle < cyclesInFlight; cycle++)
 		{
-			for(size_t sum = 0; sum < sysArraySim.Kmma(); sum++)
+			Tb->clk = Tb->clk ? 0 : 1;
+			if(sysArraySim.IoSet(Tb, &jobs, Tb->clk))
 			{
-				expected[row * colCnt + col] += matA[row * sysArraySim.Kmma() + sum] * matB[sum * colCnt + col];
+				sasError("inputSet failed\n");
+				return -1;
 			}
+
+			Tb->eval();
 		}
-	}
 
-	for(size_t jobm = 0; jobm < mCnt; jobm++)
+		return 0;
+	};
+
+	// Models of the instance in the state of newly constructed ones?
+	const auto powerOn = [&]()
 	{
-		for(size_t jobn = 0; jobn < nCnt; jobn++)
+		bool modelsPowerOn = fiRegionNetlist(sysArraySim.FiRegion_, [&](auto * netlist)
 		{
-			job_t jobStr = {
-					matA.get() + jobm * sysArraySim.Mmma() * sysArraySim.Kmma(), sysArraySim.Kmma(),
-					matB.get() + jobn * sysArraySim.Nmma(), nCnt * sysArraySim.Nmma(),
-					matC.get() + jobm * sysArraySim.Mmma() * nCnt * sysArraySim.Nmma() + jobn * sysArraySim.Nmma(), nCnt * sysArraySim.Nmma()};
+			typedef std::remove_pointer_t<decltype(netlist)> netlist_t;
+			return modelSnapshot((netlist_t*) sysArraySim.TbVoid_) == modelPowerOn<netlist_t>();
+		});
 
-			sysArraySim.DispatchMma(jobStr);
-		}
-	}
+#ifdef NETLIST
+		modelsPowerOn = modelsPowerOn &&
+				(modelSnapshot((VSystolicArray*) sysArraySim.TbFastVoid_) == modelPowerOn<VSystolicArray>());
+#endif // NETLIST
 
-	faultRTL_t faultRTL;
-	if(fiEn)
+		return modelsPowerOn;
+	};
+
+	int inFlightRet = fiRegionNetlist(sysArraySim.FiRegion_, [&](auto * netlist)
 	{
-		faultRTL = sysArraySim.FiSetRTL(fiMode::Transient);
-		if(fiMode::None == faultRTL.Mode)
-		{
-			sasError("FiSetRTL failed\n");
-			return -1;
-		}
-	}
+		return inFlight((std::remove_pointer_t<decltype(netlist)>*) sysArraySim.TbVoid_);
+	});
 
-	if(cSim)
+#ifdef NETLIST
+	inFlightRet = inFlightRet || inFlight((VSystolicArray*) sysArraySim.TbFastVoid_);
+#endif // NETLIST
+
+	if(inFlightRet)
 	{
-		if(sysArraySim.ExecCsim())
-		{
-			sasError("ExecCsim failed\n");
-			return -1;
-		}
+		return -1;
 	}
-	else
-	{
-		if(sysArraySim.ExecRtl(fastTrans, FastTransTest))
-		{
-			sasError("ExecCycle failed\n");
-			return -1;
-		}
 
-		if(!fiEn && sysArraySim.ErrorDetected())
-		{
-			sasError("False positive error detected\n");
-			return -1;
-		}
+	if(powerOn())
+	{
+		sasError("Models with jobs in flight in power on state\n");
+		return -1;
 	}
 
-	// Check if result correct
-	if(!resultCorrect(expected.data(), matC, rowCnt, colCnt))
+	// And a permanent fault
+	if(fiCsimPlace::None == sysArraySim.FiSetCsim(
+			fiCsimPlace::Everywhere, fiBits::Everywhere, fiCorruption::Flip, fiMode::Permanent).Place)
 	{
-		sasError("Output not correct\n");
+		sasError("FiSetCsim failed\n");
 		return -1;
 	}
 
-	return 0;
-}
-
-int SystolicArraySim::TileTest(bool cSim)
-{
-	SystolicArraySim sysArraySim;
-
-	std::shared_ptr<double[]> matA = randomMatrix(sysArraySim.Mtile(), sysArraySim.Ktile(), sysArraySim.Ktile());
-	std::shared_ptr<double[]> matB = randomMatrix(sysArraySim.Ktile(), sysArraySim.Ntile(), sysArraySim.Ntile());
-	std::shared_ptr<double[]> matC = randomMatrix(sysArraySim.Mtile(), sysArraySim.Ntile(), sysArraySim.Ntile());
+	sysArraySim.Reset(seed);
+	SystolicArraySim sysArraySimNew(seed);
 
-	std::vector<double> expected(sysArraySim.Mtile() * sysArraySim.Ntile());
-	memcpy(expected.data(), matC.get(), sizeof(double) * sysArraySim.Mtile() * sysArraySim.Ntile());
-	for(size_t row = 0; row < sysArraySim.Mtile(); row++)
+	if(!powerOn())
 	{
-		for(size_t col = 0; col < sysArraySim.Ntile(); col++)
-		{
-			for(size_t sum = 0; sum < sysArraySim.Ktile(); sum++)
-			{
-				expected[row * sysArraySim.Ntile() + col] += matA[row * sysArraySim.Ktile() + sum] * matB[sum * sysArraySim.Ntile() + col];
-			}
-		}
+		sasError("Reset left model state\n");
+		return -1;
 	}
 
-	job_t job = {
-			matA.get(), sysArraySim.Ktile(),
-			matB.get(), sysArraySim.Ntile(),
-			matC.get(), sysArraySim.Ntile()
-	};
-
-	sysArraySim.DispatchTile(job);
+	if((SIZE_MAX != sysArraySim.FaultCsimCycle()) || (SIZE_MAX != sysArraySim.FaultRTLCycle()) ||
+			!sysArraySim.JobQueue_.empty())
+	{
+		sasError("Reset left jobs or faults\n");
+		return -1;
+	}
 
-	if(cSim)
+	std::vector<double> outs[2][2];
+	faultCsim_t faults[2];
+	size_t faultCycles[2];
+	SystolicArraySim * const instances[2] = {&sysArraySim, &sysArraySimNew};
+	for(size_t inst = 0; inst < 2; inst++)
 	{
-		if(sysArraySim.ExecCsim())
+		out.assign(matC.get(), matC.get() + M * N);
+		instances[inst]->DispatchMma(job);
+		faults[inst] = instances[inst]->FiSetCsim(fiCsimPlace::Everywhere, fiBits::Everywhere, fiCorruption::Flip, fiMode::Transient);
+		faultCycles[inst] = instances[inst]->FaultCsimCycle();
+		if((fiCsimPlace::None == faults[inst].Place) || instances[inst]->ExecCsim() || instances[inst]->FiResetCsim())
 		{
-			sasError("ExecCsim failed\n");
+			sasError("Transient Csim fault failed\n");
 			return -1;
 		}
-	}
-	else
-	{
-		if(sysArraySim.ExecRtl())
+		outs[inst][0] = out;
+
+		out.assign(matC.get(), matC.get() + M * N);
+		instances[inst]->DispatchMma(job);
+		if(instances[inst]->ExecRtl())
 		{
-			sasError("ExecCycle failed\n");
+			sasError("ExecRtl failed\n");
 			return -1;
 		}
+		outs[inst][1] = out;
 	}
 
-	// Check if result correct
-	if(!resultCorrect(expected.data(), matC, sysArraySim.Mtile(), sysArraySim.Ntile()))
+	if((faults[0].Place != faults[1].Place) || (faults[0].BitPos != faults[1].BitPos) ||
+			(faults[0].Row != faults[1].Row) || (faultCycles[0] != faultCycles[1]))
 	{
-		sasError("Output not correct\n");
+		sasError("Reset and new instance chose different faults\n");
+		return -1;
+	}
+
+	if(memcmp(outs[0][0].data(), outs[1][0].data(), sizeof(double) * M * N) ||
+			memcmp(outs[0][1].data(), outs[1][1].data(), sizeof(double) * M * N) ||
+			(sysArraySim.ErrorDetected() != sysArraySimNew.ErrorDetected()))
+	{
+		sasError("Outputs of reset and new instance differ\n");
 		return -1;
 	}
 
@@ -1482,119 +3738,138 @@ int SystolicArraySim::GemmTest(bool cSim, const double * matA, const double * ma
 	return 0;
 }
 
-int SystolicArraySim::UnitTestNoFi(int exponentRange)
+// Sets the exponent range of the calling thread's random matrices, then runs the test
+static SystolicArraySim::unitTestCase_t unitTestCase(const std::string &name, int exponentRange, std::function<int()> test)
+{
+	return {name, [exponentRange, test]()
+	{
+		unitTestExponentRange = exponentRange;
+		return test();
+	}};
+}
+
+void SystolicArraySim::UnitTestNoFiCases(int exponentRange, std::vector<unitTestCase_t> * cases)
 {
-	unitTestExponentRange = exponentRange; // TODO: Having this global is ugly
+	const std::string suffix = " (exp. Range " + std::to_string(exponentRange) + ")";
 
 	for(size_t mCnt = 1; mCnt < 8; mCnt++)
 	{
 		for(size_t nCnt = 1; nCnt < 8; nCnt++)
 		{
-			if(MmaTest(mCnt, nCnt, false, false, false, false))
-			{
-				sasError("rtl MmaTest (mCnt = %lu, nCnt = %lu) failed\n", mCnt, nCnt);
-				return -1;
-			}
+			cases->push_back(unitTestCase("rtl MmaTest " + std::to_string(mCnt) + "x" + std::to_string(nCnt) + suffix, exponentRange,
+					[mCnt, nCnt]() {return MmaTest(mCnt, nCnt, false, false, false, false);}));
 		}
 	}
 
-	if(MultiMmaTest(false))
-	{
-		sasError("rtl MultiMmaTest failed\n");
-		return -1;
-	}
-
-	if(TileTest(false))
-	{
-		sasError("rtl TileTest failed\n");
-		return -1;
-	}
+	cases->push_back(unitTestCase("rtl MultiMmaTest" + suffix, exponentRange, []() {return MultiMmaTest(false);}));
+	cases->push_back(unitTestCase("rtl TileTest" + suffix, exponentRange, []() {return TileTest(false);}));
+	cases->push_back(unitTestCase("rtl StridedTileTest" + suffix, exponentRange, []() {return StridedTileTest(false);}));
+	cases->push_back(unitTestCase("rtl BatchTest" + suffix, exponentRange, []() {return BatchTest(false, false);}));
 
 	for(size_t matrixTest = 0; matrixTest < 5; matrixTest++)
 	{
-		std::shared_ptr<double[]> Arand = randomMatrix(14, 27, 27);
-		std::shared_ptr<double[]> Brand = randomMatrix(27, 27, 27);
-		std::shared_ptr<double[]> Crand = randomMatrix(14, 27, 27);
-
-		if(GemmTest(false, Arand.get(), Brand.get(), Crand.get(), 14, 27, 27))
+		cases->push_back(unitTestCase("rtl GemmTest " + std::to_string(matrixTest) + suffix, exponentRange, []()
 		{
-			sasError("rtl GemmTest failed\n");
-			return -1;
-		}
-	}
+			std::shared_ptr<double[]> Arand = randomMatrix(14, 27, 27);
+			std::shared_ptr<double[]> Brand = randomMatrix(27, 27, 27);
+			std::shared_ptr<double[]> Crand = randomMatrix(14, 27, 27);
 
-	return 0;
+			return GemmTest(false, Arand.get(), Brand.get(), Crand.get(), 14, 27, 27);
+		}));
+	}
 }
 
-int SystolicArraySim::UnitTest()
+std::vector<SystolicArraySim::unitTestCase_t> SystolicArraySim::UnitTestCases()
 {
+	std::vector<unitTestCase_t> cases;
+
 	// Test cSim
 	for(size_t mCnt = 1; mCnt < 8; mCnt++)
 	{
 		for(size_t nCnt = 1; nCnt < 8; nCnt++)
 		{
-			if(MmaTest(mCnt, nCnt, true, false, false, false))
-			{
-				sasError("cSim MmaTest failed (mCnt=%lu, nCnt=%lu)\n", mCnt, nCnt);
-				return -1;
-			}
+			cases.push_back(unitTestCase("cSim MmaTest " + std::to_string(mCnt) + "x" + std::to_string(nCnt), INT_MAX,
+					[mCnt, nCnt]() {return MmaTest(mCnt, nCnt, true, false, false, false);}));
 		}
 	}
 
-	if(MultiMmaTest(true))
-	{
-		sasError("cSim MultiMmaTest failed\n");
-		return -1;
-	}
-
-	if(TileTest(true))
-	{
-		sasError("cSim TileTest failed\n");
-		return -1;
-	}
+	cases.push_back(unitTestCase("cSim MultiMmaTest", INT_MAX, []() {return MultiMmaTest(true);}));
+	cases.push_back(unitTestCase("cSim TileTest", INT_MAX, []() {return TileTest(true);}));
+	cases.push_back(unitTestCase("cSim StridedTileTest", INT_MAX, []() {return StridedTileTest(true);}));
+	cases.push_back(unitTestCase("cSim FiCopyTest", INT_MAX, []() {return FiCopyTest(true);}));
+	cases.push_back(unitTestCase("cSim SeedTest", INT_MAX, []() {return SeedTest();}));
+	cases.push_back(unitTestCase("ResetTest", INT_MAX, []() {return ResetTest();}));
+	cases.push_back(unitTestCase("DictTest", INT_MAX, []() {return DictTest();}));
+	cases.push_back(unitTestCase("cSim ReplayTest", INT_MAX, []() {return ReplayTest(true);}));
 
 	for(size_t matrixTest = 0; matrixTest < 5; matrixTest++)
 	{
-		std::shared_ptr<double[]> Arand = randomMatrix(14, 27, 27);
-		std::shared_ptr<double[]> Brand = randomMatrix(27, 27, 27);
-		std::shared_ptr<double[]> Crand = randomMatrix(14, 27, 27);
-
-		if(GemmTest(true, Arand.get(), Brand.get(), Crand.get(), 14, 27, 27))
+		cases.push_back(unitTestCase("cSim GemmTest " + std::to_string(matrixTest), INT_MAX, []()
 		{
-			sasError("cSim GemmTest failed\n");
-			return -1;
-		}
+			std::shared_ptr<double[]> Arand = randomMatrix(14, 27, 27);
+			std::shared_ptr<double[]> Brand = randomMatrix(27, 27, 27);
+			std::shared_ptr<double[]> Crand = randomMatrix(14, 27, 27);
+
+			return GemmTest(true, Arand.get(), Brand.get(), Crand.get(), 14, 27, 27);
+		}));
 	}
 
 	// Test rtl
 	// Test stuff without faults
-	if(UnitTestNoFi(5))
-	{
-		sasError("UnitTestNoFi failed (exp. Range %i)\n", unitTestExponentRange);
-		return -1;
-	}
-
-	if(UnitTestNoFi(100))
-	{
-		sasError("UnitTestNoFi failed (exp. Range %i)\n", unitTestExponentRange);
-		return -1;
-	}
+	UnitTestNoFiCases(5, &cases);
+	UnitTestNoFiCases(100, &cases);
 
 #ifdef NETLIST
 	// Test stuff with faults (and fast trans)
-	unitTestExponentRange = 10; // TODO: Having this global is ugly
 	for(size_t mCnt = 1; mCnt < 8; mCnt++)
 	{
 		for(size_t nCnt = 1; nCnt < 8; nCnt++)
 		{
-			if(MmaTest(mCnt, nCnt, false, true, true, true))
-			{
-				sasError("rtl fast transient MmaTest failed (mCnt=%lu, nCnt=%lu)\n", mCnt, nCnt);
-				return -1;
-			}
+			cases.push_back(unitTestCase("rtl fast transient MmaTest " + std::to_string(mCnt) + "x" + std::to_string(nCnt), 10,
+					[mCnt, nCnt]() {return MmaTest(mCnt, nCnt, false, true, true, true);}));
 		}
 	}
+
+	cases.push_back(unitTestCase("rtl FiCopyTest", 10, []() {return FiCopyTest(false);}));
+	cases.push_back(unitTestCase("rtl ReplayTest", 10, []() {return ReplayTest(false);}));
+	cases.push_back(unitTestCase("rtl BatchTest", 10, []() {return BatchTest(true, false);}));
+	cases.push_back(unitTestCase("rtl fast transient BatchTest", 10, []() {return BatchTest(true, true);}));
+	cases.push_back(unitTestCase("rtl ModelTest", 10, []() {return ModelTest();}));
+	cases.push_back(unitTestCase("rtl RegionTest", 10, []() {return RegionTest();}));
+	cases.push_back(unitTestCase("rtl CoiTest", 10, []() {return CoiTest();}));
+	cases.push_back(unitTestCase("rtl DictCharacterizeTest", 10, []() {return DictCharacterizeTest();}));
 #endif // NETLIST
 
+	return cases;
+}
+
+int SystolicArraySim::UnitTestNoFi(int exponentRange)
+{
+	std::vector<unitTestCase_t> cases;
+	UnitTestNoFiCases(exponentRange, &cases);
+
+	for(const auto &testCase : cases)
+	{
+		if(testCase.Run())
+		{
+			sasError("%s failed\n", testCase.Name.c_str());
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int SystolicArraySim::UnitTest()
+{
+	for(const auto &testCase : UnitTestCases())
+	{
+		if(testCase.Run())
+		{
+			sasError("%s failed\n", testCase.Name.c_str());
+			return -1;
+		}
+	}
+
 	return 0;
 }
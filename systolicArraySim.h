@@ -24,12 +24,21 @@
 #include <stdint.h>
 
 #include <deque>
+#include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "prng.h"
+#include "faultDictionary.h"
+
+class FaultSampler;
+
 class SystolicArraySim {
 public:
 	// NOTE: Constructor assumes srand() was called!
 	SystolicArraySim();
+	explicit SystolicArraySim(uint64_t seed); // seed for fault site, bit, cycle and row choices
 	virtual ~SystolicArraySim();
 
 	// Prevent copying (alternatively, implement copy/asgn duplicating cpy)
@@ -47,15 +56,27 @@ public:
 	const size_t &ThreadsPerSA() const {return Config_.ThreadCnt;};
 	const size_t &SACnt() const {return Config_.SystolicArrayCnt;};
 
+	// Geometry of the linked model (M_MMA and K_MMA in the Makefile): Kmma is its K_MMA, and of the Mmma rows,
+	// the first MmmaRtl are simulated on it. The others are computed directly
+	static size_t MmmaRtl();
+
 	size_t RequiredOutPositionsBetweenK() const {return 4;}; // = jobCycleDone / jobCyclePassedFirstStage // TODO: Put these into header
+	size_t CyclesRequired(size_t jobCnt) const; // cycles to simulate jobCnt dispatched MMAs
 
 	typedef struct {
-		const double * MatA; // row-major Mmma x Kmma / Mtile x Ktile matrix
-		size_t StrideA; // >= Kmma / Ktile
-		const double * MatB; // row-major Kmma x Nmma / .. tile matrix
-		size_t StrideB; // >= Nmma / Ntile
-		double * MatC; // row-major Mmma x Nmma / .. tile matrix
-		size_t StrideC; // >= Nmma / Ntile
+		const double * MatA; // Mmma x Kmma / Mtile x Ktile matrix
+		size_t StrideA; // row stride, >= Kmma / Ktile if row-major
+		const double * MatB; // Kmma x Nmma / .. tile matrix
+		size_t StrideB; // row stride, >= Nmma / Ntile if row-major
+		double * MatC; // Mmma x Nmma / .. tile matrix
+		size_t StrideC; // row stride, >= Nmma / Ntile if row-major
+		size_t ColStrideA = 1; // column stride, i.e. 1 for row-major, >= Mmma / Mtile for column-major
+		size_t ColStrideB = 1; // >= Kmma / Ktile for column-major
+		size_t ColStrideC = 1; // >= Mmma / Mtile for column-major
+
+		const double &ElemA(size_t row, size_t col) const {return MatA[row * StrideA + col * ColStrideA];};
+		const double &ElemB(size_t row, size_t col) const {return MatB[row * StrideB + col * ColStrideB];};
+		double &ElemC(size_t row, size_t col) const {return MatC[row * StrideC + col * ColStrideC];};
 	} job_t;
 
 	int DispatchMma(const job_t &job);
@@ -68,11 +89,45 @@ public:
 	int ExecRtl(bool fastTransient = false, bool fastTransientTest = false);
 	int ExecCsim(size_t maxJobs = SIZE_MAX);
 
+	// NETLIST builds: ExecRtl without an active fault (none set, or fastTransientTest) runs on the
+	// uninstrumented RTL model, bit-identical to the netlist but faster. Disable to always run the netlist
+	void FastModelEn(bool enable) {FastModelEn_ = enable;};
+
+	// Cone of influence simulation of transient faults inside an FMA (NETLIST builds, fast model enabled):
+	// fmaInstances[k] is the first ModuleInstanceChain entry of the sites in fma_m[0].fma_k[k].fma.
+	// ExecRtl then runs the fast model and only the faulty FMA from the netlist, fed with its recorded
+	// inputs (its sites without the first chain entry). If the fault reaches the FMA's output, the job queue
+	// is simulated again on the netlist. Wrong instances would report FMA faults as masked: CoiTest
+	// (testNetlist --coi) checks them against the netlist. Applies to all instances, set before simulating.
+	// Empty disables
+	static int CoiEnable(const std::vector<uint16_t> &fmaInstances);
+
 	bool ErrorDetected() const {return DieError_;}; //  parity, residue, or protocol error raised inside RTL
+	void ErrorDetectedReset() {DieError_ = false;}; // e.g. before simulating another fault on this instance
+
+	// Returns to the state of an instance newly constructed with seed, keeping the models allocated, the
+	// FI region and DictUse: Jobs, faults, cycle count and error are cleared, the models restored to their power-on state
+	// from a snapshot. For campaigns and tests simulating many experiments on one instance per thread
+	void Reset(uint64_t seed);
+
+	// Reseeds the random fault choices only, e.g. per simulated GEMM position so that they don't depend on
+	// which faults this instance simulated before
+	void Seed(uint64_t seed) {Prng_.Seed(seed);};
 
 	static int UnitTest(); // Assumes srand was called outside!
 	static int UnitTestNoFi(int exponentRange);
 
+	// The cases of UnitTest: Independent of each other and of the thread running them, so they can be
+	// sharded and run in parallel. Each creates its own simulators, random draws are from threadPrng()
+	// of the running thread, netlist fault sites from rand() seeded by the drawing instance (see FiSetRTL).
+	// Instances created on other threads (e.g. simulation server workers) are seeded independently
+	typedef struct {
+		std::string Name;
+		std::function<int()> Run;
+	} unitTestCase_t;
+
+	static std::vector<unitTestCase_t> UnitTestCases();
+
 	// Fault stuff
 
 	// For Csim fault sim
@@ -98,14 +153,22 @@ public:
 		Inputs,
 		Multipliers,
 		AccAdders,
-		ColumnAdders}; // Don't add enums without chaing FiSetCsim
+		ColumnAdders,
+		Fma}; // Don't add enums without chaing FiSetCsim
 
+	// Fma: Transient fault of the FMA netlist, drawn from the fault dictionary (see DictEnable).
+	// Corruption and bits are given by the dictionary pattern, BitPos is unused
 	typedef struct {
 		fiCsimPlace Place = fiCsimPlace::None;
 		fiCorruption Corruption = fiCorruption::None;
 		fiMode Mode = fiMode::None;
 		uint8_t BitPos = UINT8_MAX;
 		uint8_t Row = 0;
+		uint8_t Fma = 0; // Fma, Multipliers, AccAdders, Inputs: k of the FMA in the row
+		uint8_t Input = 0; // Multipliers, Inputs: input corrupted, 0: accumulator, 1: A, 2: B
+		uint32_t Site = UINT32_MAX; // Fma: site of the fault dictionary
+		uint16_t SiteBit = UINT16_MAX; // Fma: bit of the site's signal
+		uint32_t SitePattern = UINT32_MAX; // Fma: pattern index of the site's bit in the fault's phase
 	} faultCsim_t;
 
 	// Returns the actual (random) fault chosen
@@ -118,8 +181,31 @@ public:
 			fiCorruption corruption,
 			fiMode mode);
 
+	// Sets the given permanent fault, e.g. one returned by FiSetCsim of another instance
+	int FiSetCsim(const faultCsim_t &fault);
+
+	// Sets the given transient fault to occur in cycle of the current job queue, e.g. to replay
+	// a fault returned by FiSetCsim together with FaultCsimCycle(). The fault's Fma and Input are
+	// replayed as given, the pattern of an Fma fault is its SitePattern.
+	// Fma faults count cycles as the RTL simulation (see CyclesRequired), the others per column
+	int FiSetCsim(const faultCsim_t &fault, size_t cycle);
+	size_t FaultCsimCycle() const {return FaultCsimTransCycle_;}; // SIZE_MAX if no transient fault set
+
 	int FiResetCsim();
 
+	// Fault dictionary of fiCsimPlace::Fma faults, see faultDictionary.h. Applies to all instances
+	// without one of their own (DictUse), set before simulating. nullptr disables
+	static int DictEnable(const char * path);
+
+	// Fault dictionary of this instance only, in place of DictEnable's. nullptr returns to that
+	void DictUse(std::shared_ptr<const FaultDictionary> dict) {Dict_ = std::move(dict);};
+
+	// Characterizes transient faults of siteCnt sites drawn from the FMAs of the netlist (fmaInstances as
+	// for CoiEnable), every bit in both clock phases with operandSets sets of random operands
+	// (exponents within +- expRange). Sites characterized before only count as drawn (NETLIST builds)
+	static int DictCharacterize(FaultDictionary * dict, const std::vector<uint16_t> &fmaInstances,
+			size_t siteCnt, size_t operandSets, int expRange);
+
 	// For RTL fault sim
 	typedef struct {
 		std::vector<uint16_t> ModuleInstanceChain;
@@ -132,9 +218,37 @@ public:
 	// NOTE: If transient fault is chosen, it will execute randomly
 	// within current job-Queue - so dispatch jobs first.
 	// Struct elements are set to "None" upon error
-	faultRTL_t FiSetRTL(fiMode mode);
+	// sampler: Site is drawn from the sampler's target stratum, returned in stratum
+	faultRTL_t FiSetRTL(fiMode mode, FaultSampler * sampler = nullptr, std::string * stratum = nullptr);
+
+	// Sets the given permanent fault, e.g. one returned by FiSetRTL of another instance
+	int FiSetRTL(const faultRTL_t &fault);
+
+	// Sets the given transient fault to occur in cycle of the current job queue, e.g. to replay
+	// a fault returned by FiSetRTL together with FaultRTLCycle()
+	int FiSetRTL(const faultRTL_t &fault, size_t cycle);
+	size_t FaultRTLCycle() const {return FaultRTLTransCycle_;}; // SIZE_MAX if no transient fault set
+
 	int FiResetRTL();
 
+	// Netlist simulated with RTL faults: Only the assigns of the FI region's modules are fault sites, the logic
+	// outside of it isn't instrumented and simulates faster. "SystolicArray" (the default) is the fully
+	// instrumented netlist, NETLIST builds link the others of FI_REGIONS in the Makefile. Drops the models and the
+	// RTL fault of the previous region, so select the region before simulating. Kept by Reset
+	int FiRegionSet(const char * region);
+	const char * FiRegion() const;
+	static std::vector<std::string> FiRegions(); // linked regions, "SystolicArray" first
+
+	// Simulates the current job queue once per fault, each on an own testbench, all stepped in lockstep:
+	// A and B inputs are encoded once per cycle and copied to the other testbenches.
+	// faults[f] (fiMode::None for a fault free run) occurs in cycles[f] if transient, see FiSetRTL.
+	// Instead of the jobs' C, run f writes to matCs[f]: A copy of the matrix at matC holding all jobs' C.
+	// fastTransient: Retire a transient run once its fault is flushed out, finishing with the C model
+	// errorsDetected (optional): RTL error raised in run f
+	int ExecRtlBatch(const std::vector<faultRTL_t> &faults, const std::vector<size_t> &cycles,
+			const double * matC, const std::vector<double *> &matCs,
+			bool fastTransient = false, std::vector<bool> * errorsDetected = nullptr);
+
 private:
 
 	size_t CycleCnt_ = 0;
@@ -152,12 +266,43 @@ private:
 		size_t SystolicArrayCnt; // how many SAs work in parallel?
 	} config_t;
 
-	const config_t Config_ = {
-			8, 8, 8, // Mmma, Kmma, Nmma
-			8, 2, // BufferLeftSize, BufferRightSize
-			8 * 4, 4 * 8, // Mtile, Ntile
-			4, 16}; // ThreadCnt, SystolicArrayCnt
-	void * TbVoid_;
+	static config_t ConfigGet(); // of the linked model's geometry
+	const config_t Config_ = ConfigGet();
+	size_t FiRegion_ = 0; // see FiRegionSet
+	void * TbVoid_ = nullptr; // netlist of the FI region, created by first ExecRtl
+	void * TbFastVoid_ = nullptr; // NETLIST builds: RTL model, created by first fault free ExecRtl
+	void * ContextVoid_ = nullptr; // VerilatedContext of all models of the instance, created by the first ModelNew
+	bool FastModelEn_ = true;
+
+	typedef struct {
+		size_t Cycle;
+		bool Clk;
+		uint32_t Mult1[3]; // 65'b values as in the testbench
+		uint32_t Mult2[3];
+		uint32_t Acc[3];
+	} fmaInput_t;
+
+	std::vector<fmaInput_t> * FmaInputs_ = nullptr; // ExecRtlTb records the inputs of FMA FmaInputsIndex_ here
+	size_t FmaInputsIndex_ = 0;
+	void * TbFmaVoid_[2] = {nullptr, nullptr}; // faulty and fault free FMA of the cone of influence simulation
+
+	template <typename testBench>
+	static void FmaInputGet(const testBench * Tb, size_t fma, fmaInput_t * input);
+
+	int ExecCoi(size_t fma, bool fastTransient);
+
+	template <typename fmaModel>
+	bool CoiMasked(const fmaModel * type, const std::vector<fmaInput_t> &inputs, size_t fma);
+
+	int ExecNetlist(bool fastTransient, bool fastTransientTest);
+	void ModelsDelete(); // of the FI region, not the RTL model
+
+	template <typename testBench>
+	testBench * ModelNew(); // with the instance's VerilatedContext
+
+	int ExecDict(size_t maxJobs);
+	faultCsim_t FiSetCsimFma(fiMode mode);
+	bool FiCsimFmaValid(const faultCsim_t &fault) const;
 
 	typedef struct {
 		size_t JobCycle;
@@ -169,33 +314,61 @@ private:
 
 	int RowCsim(double * out, double * a, double * b, const faultCsim_t * fi = nullptr) const;
 
-	int IoSet(void * Tb, std::deque<queueEntry_t> * jobs, bool clkHigh);
+	mutable Prng Prng_; // all random fault choices, incl. those of RowCsim
+
+	// operandTb: Copy A and B inputs from this testbench instead of encoding them
+	template <typename testBench>
+	int IoSet(testBench * Tb, std::deque<queueEntry_t> * jobs, bool clkHigh, const testBench * operandTb = nullptr);
+
+	template <typename testBench>
+	int ExecRtlTb(testBench * Tb, bool fastTransient, bool fastTransientTest);
+
+	std::vector<void *> BatchTbVoid_; // testbenches of ExecRtlBatch, kept for later batches
+
+	template <typename testBench>
+	int ExecRtlBatchTb(const testBench * type, const std::vector<faultRTL_t> &faults, const std::vector<size_t> &cycles,
+			const double * matC, const std::vector<double *> &matCs, bool fastTransient, std::vector<bool> * errorsDetected);
 
 	const size_t FmaCycles_ = 12;
 	const size_t JobCycleOutputStart_ = (Kmma() / 2) * FmaCycles_ + 4;
 	const size_t JobCycleDone_ = JobCycleOutputStart_ + 2 * (Nmma() - 1);
 	const size_t JobCyclePassedFirstStage_ = 2 * Nmma() + 1;
 
-	size_t CyclesRequired(size_t jobCnt) const;
 	size_t JobsDoneInCycles(size_t cycleCnt) const;
 
 	static int MmaTest(size_t mCnt, size_t nCnt, bool cSim, bool fiEn, bool fastTrans, bool FastTransTest);
 	static int MultiMmaTest(bool cSim);
 	static int TileTest(bool cSim);
+	static int StridedTileTest(bool cSim);
+	static int FiCopyTest(bool cSim);
+	static int SeedTest();
+	static int ResetTest();
+	static int ReplayTest(bool cSim);
+	static int BatchTest(bool fiEn, bool fastTransient);
+	static int ModelTest();
+	static int RegionTest();
+	static int CoiTest();
+	static int DictTest();
+	static int DictCharacterizeTest();
 	static int GemmTest(bool cSim, const double * A, const double * B, const double * C, size_t M, size_t K, size_t N);
+	static void UnitTestNoFiCases(int exponentRange, std::vector<unitTestCase_t> * cases);
 
 	// Fault stuff
 	// For Csim fault sim
 	faultCsim_t FaultCsim_;
 	size_t FaultCsimTransCycle_ = SIZE_MAX; // for transient faults: In which cycle should fault occur?
+	FaultDictionary::pattern_t FaultDictPattern_; // fiCsimPlace::Fma: Output error pattern drawn by FiSetCsim
+	std::shared_ptr<const FaultDictionary> Dict_; // see DictUse
+	const FaultDictionary * Dict() const; // Dict_, else the one of DictEnable
 
 	// For RTL fault sim
 	faultRTL_t FaultRTL_;
 	size_t FaultRTLTransCycle_ = SIZE_MAX; // for transient faults: In which cycle should fault occur?
-	void * NetlistFaultInjectorVoid_ = nullptr;
 
-	static int FiRtlApply(void * TbVoid, const std::vector<uint16_t> &modInst, uint32_t assignNr, size_t fiBit);
-	static int FiRtlReset(void * TbVoid);
+	template <typename testBench>
+	static int FiRtlApply(testBench * Tb, const std::vector<uint16_t> &modInst, uint32_t assignNr, size_t fiBit);
+	template <typename testBench>
+	static int FiRtlReset(testBench * Tb);
 };
 
 #endif /* SYSTOLICARRAYSIM_H_ */